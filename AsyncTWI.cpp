@@ -0,0 +1,196 @@
+/*
+  AsyncTWI.cpp - Queues I2C transactions and completes them from the TWI interrupt
+*/
+
+#include <Arduino.h>
+#include "AsyncTWI.h"
+
+#if defined(TWI_INTERRUPT)
+#include <util/atomic.h>
+#include <util/twi.h>
+#else
+#include <Wire.h>
+#endif
+
+AsyncTWI::Transaction AsyncTWI::transactions[TWI_QUEUE];
+volatile uint8_t AsyncTWI::head = 0;
+volatile uint8_t AsyncTWI::tail = 0;
+volatile bool AsyncTWI::reading = false;
+volatile uint8_t AsyncTWI::index = 0;
+
+#if defined(TWI_INTERRUPT)
+//Drives transactions (Wire must not be used alongside, it owns the same vector, see AsyncTWI.h)
+ISR(TWI_vect) {
+    AsyncTWI::handleInterrupt();
+}
+#endif
+
+void AsyncTWI::begin(uint32_t clock) {
+#if defined(TWI_INTERRUPT)
+    //Internal pullups on bus lines
+    pinMode(SDA, INPUT_PULLUP);
+    pinMode(SCL, INPUT_PULLUP);
+
+    //Bit rate with prescaler of 1
+    TWSR &= ~(_BV(TWPS0) | _BV(TWPS1));
+    TWBR = ((F_CPU / clock) - 16) / 2;
+    TWCR = _BV(TWEN);
+#else
+    Wire.begin();
+    Wire.setClock(clock);
+#endif
+}
+
+//Adds transaction to queue, returns false if queue is full
+bool AsyncTWI::queue(uint8_t address, const uint8_t* writeData, uint8_t writeLength, volatile uint8_t* readData, uint8_t readLength, volatile uint8_t* status) {
+    if (writeLength > TWI_WRITE_MAX) {
+        return false;
+    }
+
+#if defined(TWI_INTERRUPT)
+    //Only interrupt moves tail, so a free slot stays free
+    uint8_t next = (head + 1) % TWI_QUEUE;
+    if (next == tail) {
+        return false;
+    }
+
+    //Copies write bytes so caller's buffer can go out of scope
+    Transaction* transaction = &transactions[head];
+    transaction->address = address;
+    for (int i = 0; i < writeLength; i++) {
+        transaction->writeData[i] = writeData[i];
+    }
+    transaction->writeLength = writeLength;
+    transaction->readData = readData;
+    transaction->readLength = readLength;
+    transaction->status = status;
+
+    if (status) {
+        *status = TWI_PENDING;
+    }
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        //Starts bus if nothing was in progress
+        bool idle = (head == tail);
+        head = next;
+        if (idle) {
+            start();
+        }
+    }
+#else
+    //Completes transaction before returning
+    Wire.beginTransmission(address);
+    for (int i = 0; i < writeLength; i++) {
+        Wire.write(writeData[i]);
+    }
+    bool success = (Wire.endTransmission(readLength == 0) == 0);
+
+    if (success && (readLength > 0)) {
+        success = (Wire.requestFrom(address, readLength) == readLength);
+        for (int i = 0; success && (i < readLength); i++) {
+            readData[i] = Wire.read();
+        }
+    }
+
+    if (status) {
+        *status = success ? TWI_COMPLETE : TWI_FAILED;
+    }
+#endif
+    return true;
+}
+
+//Whether transactions are waiting or in progress
+bool AsyncTWI::busy() {
+    return head != tail;
+}
+
+//Sends start condition for transaction at tail
+void AsyncTWI::start() {
+#if defined(TWI_INTERRUPT)
+    reading = (transactions[tail].writeLength == 0);
+    index = 0;
+
+    //Waits out stop condition of last transaction
+    while (TWCR & _BV(TWSTO)) {
+
+    }
+    TWCR = _BV(TWINT) | _BV(TWSTA) | _BV(TWEN) | _BV(TWIE);
+#endif
+}
+
+//Reports transaction at tail and moves on to next one
+void AsyncTWI::finish(uint8_t status) {
+#if defined(TWI_INTERRUPT)
+    Transaction* transaction = &transactions[tail];
+    if (transaction->status) {
+        *transaction->status = status;
+    }
+
+    tail = (tail + 1) % TWI_QUEUE;
+    if (tail != head) {
+        //Stop followed by start of next transaction
+        reading = (transactions[tail].writeLength == 0);
+        index = 0;
+        TWCR = _BV(TWINT) | _BV(TWSTO) | _BV(TWSTA) | _BV(TWEN) | _BV(TWIE);
+    } else {
+        TWCR = _BV(TWINT) | _BV(TWSTO) | _BV(TWEN);
+    }
+#else
+    (void) status;
+#endif
+}
+
+//Advances transaction at tail after each bus event
+void AsyncTWI::handleInterrupt() {
+#if defined(TWI_INTERRUPT)
+    Transaction* transaction = &transactions[tail];
+
+    switch (TW_STATUS) {
+        case TW_START:
+        case TW_REP_START:
+            //Addresses device for current phase
+            TWDR = (transaction->address << 1) | (reading ? TW_READ : TW_WRITE);
+            TWCR = _BV(TWINT) | _BV(TWEN) | _BV(TWIE);
+            break;
+
+        case TW_MT_SLA_ACK:
+        case TW_MT_DATA_ACK:
+            if (index < transaction->writeLength) {
+                TWDR = transaction->writeData[index];
+                index++;
+                TWCR = _BV(TWINT) | _BV(TWEN) | _BV(TWIE);
+            } else if (transaction->readLength > 0) {
+                //Repeated start into read phase
+                reading = true;
+                index = 0;
+                TWCR = _BV(TWINT) | _BV(TWSTA) | _BV(TWEN) | _BV(TWIE);
+            } else {
+                finish(TWI_COMPLETE);
+            }
+            break;
+
+        case TW_MR_DATA_ACK:
+            transaction->readData[index] = TWDR;
+            index++;
+            //Falls through to acknowledge all but last byte
+
+        case TW_MR_SLA_ACK:
+            if ((index + 1) < transaction->readLength) {
+                TWCR = _BV(TWINT) | _BV(TWEA) | _BV(TWEN) | _BV(TWIE);
+            } else {
+                TWCR = _BV(TWINT) | _BV(TWEN) | _BV(TWIE);
+            }
+            break;
+
+        case TW_MR_DATA_NACK:
+            transaction->readData[index] = TWDR;
+            finish(TWI_COMPLETE);
+            break;
+
+        default:
+            //Not acknowledged, arbitration lost or bus error
+            finish(TWI_FAILED);
+            break;
+    }
+#endif
+}
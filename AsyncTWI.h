@@ -0,0 +1,68 @@
+/*
+  AsyncTWI.h - Queues I2C transactions and completes them from the TWI interrupt
+*/
+
+#ifndef AsyncTWI_h
+#define AsyncTWI_h
+
+#include <Arduino.h>
+
+//On AVR transactions run from the TWI interrupt, which owns the same vector as Wire, so a sketch
+//linking Wire (for another I2C device) fails with a duplicate __vector_24. Defining TOWER_USE_WIRE
+//for the build (compiler.cpp.extra_flags=-DTOWER_USE_WIRE) completes transactions through Wire instead.
+#if defined(__AVR__) && !defined(TOWER_USE_WIRE)
+#define TWI_INTERRUPT
+#endif
+
+//Transactions waiting or in progress
+#define TWI_QUEUE 4
+
+//Most bytes written by one transaction
+#define TWI_WRITE_MAX 3
+
+//Transaction status
+#define TWI_IDLE 0
+#define TWI_PENDING 1
+#define TWI_COMPLETE 2
+#define TWI_FAILED 3
+
+class AsyncTWI {
+    private:
+        struct Transaction {
+            //7 bit device address
+            uint8_t address;
+
+            //Bytes written before reading
+            uint8_t writeData[TWI_WRITE_MAX];
+            uint8_t writeLength;
+
+            //Buffer filled by reading
+            volatile uint8_t* readData;
+            uint8_t readLength;
+
+            //Set to complete or failed when finished
+            volatile uint8_t* status;
+        };
+
+        static Transaction transactions[TWI_QUEUE];
+
+        //Next free slot and transaction in progress
+        static volatile uint8_t head;
+        static volatile uint8_t tail;
+
+        //Whether current transaction is in read phase and byte index within phase
+        static volatile bool reading;
+        static volatile uint8_t index;
+
+        static void start();
+        static void finish(uint8_t status);
+    public:
+        static void begin(uint32_t clock);
+
+        static bool queue(uint8_t address, const uint8_t* writeData, uint8_t writeLength, volatile uint8_t* readData, uint8_t readLength, volatile uint8_t* status);
+        static bool busy();
+
+        static void handleInterrupt();
+};
+
+#endif
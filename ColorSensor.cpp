@@ -1,15 +1,17 @@
 /*
-  ColorSensor.cpp - Detects block colors with Adafruit TCS34725 Color Sensor
+  ColorSensor.cpp - Detects block colors with TCS34725 Color Sensor
   Created by Carson G. Ray, January 4 2022.
 */
 
 #include <Arduino.h>
-#include <Wire.h>
-#include <Adafruit_TCS34725.h>
+#include "AsyncTWI.h"
 #include "TowerRobot.h"
 
+//Gain multiplier of each gain index (1x, 4x, 16x, 60x)
+const uint8_t gains[4] = {1, 4, 16, 60};
+
 TowerRobot::ColorSensor::ColorSensor() {
-    tcs = Adafruit_TCS34725(TCS34725_INTEGRATIONTIME_50MS, TCS34725_GAIN_4X);
+    updateCentroids();
 }
 
 int TowerRobot::ColorSensor::numColors() {
@@ -17,82 +19,495 @@ int TowerRobot::ColorSensor::numColors() {
 }
 
 bool TowerRobot::ColorSensor::begin() {
-    return tcs.begin();
+    AsyncTWI::begin(TCS_CLOCK);
+
+    //Waits for sensor to answer with a TCS3472x id (into members, so a stuck read never writes to a dead stack)
+    unsigned long start = millis();
+    readRegs(TCS_ID, data, 1, &burst);
+    while ((burst == TWI_PENDING) && ((millis() - start) < TCS_BEGIN_TIMEOUT)) {
+
+    }
+
+    if ((burst != TWI_COMPLETE) || ((data[0] != 0x44) && (data[0] != 0x4D))) {
+        return false;
+    }
+    burst = TWI_IDLE;
+
+    //Writes integration time and gain
+    uint8_t atime = 256 - cycles;
+    uint8_t control = gainIndex;
+    writeRegs(TCS_ATIME, &atime, 1);
+    writeRegs(TCS_CONTROL, &control, 1);
+
+    //Powers on with LED off, then starts integrating
+    enable = TCS_PON | TCS_AIEN;
+    writeRegs(TCS_ENABLE, &enable, 1);
+    delay(3);
+    restart(false);
+
+    return true;
 }
 
-void TowerRobot::ColorSensor::getRaw(bool led, int* r, int*g, int*b, int* c) {
-    //Whether LED is on or off
+//Queues read of consecutive registers, status is set when values arrive
+bool TowerRobot::ColorSensor::readRegs(uint8_t reg, volatile uint8_t* values, int length, volatile uint8_t* status) {
+    uint8_t command = TCS_AUTO_INC | reg;
+    return AsyncTWI::queue(TCS_ADDRESS, &command, 1, values, length, status);
+}
+
+//Queues write of consecutive registers (up to 2)
+bool TowerRobot::ColorSensor::writeRegs(uint8_t reg, uint8_t* values, int length) {
+    uint8_t bytes[TWI_WRITE_MAX];
+    bytes[0] = (length > 1 ? TCS_AUTO_INC : TCS_COMMAND) | reg;
+    for (int i = 0; i < length; i++) {
+        bytes[i + 1] = values[i];
+    }
+
+    //Waits for room rather than dropping a config write
+    while (!AsyncTWI::queue(TCS_ADDRESS, bytes, length + 1, NULL, 0, NULL)) {
+
+    }
+    return true;
+}
+
+int TowerRobot::ColorSensor::getEmptyThres() {
+    return emptyThres;
+}
+
+void TowerRobot::ColorSensor::setEmptyThres(int emptyThres) {
+    this->emptyThres = emptyThres;
+}
+
+//Gets reflected values of block color
+void TowerRobot::ColorSensor::getColorValues(int color, int* r, int* g, int* b) {
+    *r = blockColors[color][0];
+    *g = blockColors[color][1];
+    *b = blockColors[color][2];
+}
+
+//Sets reflected values of block color
+void TowerRobot::ColorSensor::setColorValues(int color, int r, int g, int b) {
+    blockColors[color][0] = r;
+    blockColors[color][1] = g;
+    blockColors[color][2] = b;
+    updateCentroids();
+}
+
+//Precomputes chromaticity of each color and intensity split between black and white
+void TowerRobot::ColorSensor::updateCentroids() {
+    for (int col = 0; col < numColors(); col++) {
+        long sum = (long) blockColors[col][0] + blockColors[col][1] + blockColors[col][2];
+        sum = max(sum, 1L);
+
+        //Red and green share of intensity out of 256 (blue is the rest)
+        chroma[col][0] = 256L * blockColors[col][0] / sum;
+        chroma[col][1] = 256L * blockColors[col][1] / sum;
+    }
+
+    //Black and white have the same chromaticity, so intensity splits them at its geometric mean
+    long black = (long) blockColors[BLACK][0] + blockColors[BLACK][1] + blockColors[BLACK][2];
+    long white = (long) blockColors[WHITE][0] + blockColors[WHITE][1] + blockColors[WHITE][2];
+    neutralThres = sqrt((float) max(black, 1L) * max(white, 1L));
+}
+
+//Learns color values (or empty threshold) from samples of a block held at sensor
+bool TowerRobot::ColorSensor::calibrate(int color, int samples) {
+    if ((color < EMPTY) || (color >= numColors()) || (samples <= 0)) {
+        return false;
+    }
+
+    //Full length reads so every sample is equally precise
+    bool wasAdaptive = adaptive;
+    adaptive = false;
+
+    long sums[4] = {0, 0, 0, 0};
+    int maxClear = 0;
+    for (int i = 0; i < samples; i++) {
+        int channels[4];
+        getReflected(&channels[0], &channels[1], &channels[2], &channels[3]);
+
+        for (int ch = 0; ch < 4; ch++) {
+            sums[ch] += channels[ch];
+        }
+        maxClear = max(maxClear, channels[3]);
+    }
+
+    adaptive = wasAdaptive;
+
+    if (color == EMPTY) {
+        //Threshold sits above brightest empty read by allowed drift
+        setEmptyThres(maxClear + driftThres);
+    } else {
+        //Rejects samples too dim to be a block
+        if ((sums[3] / samples) <= emptyThres) {
+            return false;
+        }
+        setColorValues(color, sums[0] / samples, sums[1] / samples, sums[2] / samples);
+    }
+
+    return true;
+}
+
+//Turns LED on or off (LED is driven by interrupt pin)
+void TowerRobot::ColorSensor::setLed(bool led) {
     if (led) {
-        tcs.setInterrupt(false);  // turn on LED
+        enable &= ~TCS_AIEN;
+    } else {
+        enable |= TCS_AIEN;
+    }
+    writeRegs(TCS_ENABLE, &enable, 1);
+}
 
-        delay(100);  // takes 50ms to read
-    
-        tcs.getRawData(r, g, b, c);
+//Sets integration time (written on next restart) and gain
+void TowerRobot::ColorSensor::setIntegration(uint8_t cycles, int gainIndex) {
+    this->cycles = cycles;
 
-        tcs.setInterrupt(true); // turn off LED
+    //Gain register is only written when it changes
+    if (gainIndex != this->gainIndex) {
+        uint8_t control = gainIndex;
+        writeRegs(TCS_CONTROL, &control, 1);
+        this->gainIndex = gainIndex;
+    }
+}
+
+//Restarts integration with LED on or off so next valid data is fresh
+void TowerRobot::ColorSensor::restart(bool led) {
+    if (led) {
+        enable &= ~TCS_AIEN;
     } else {
-        tcs.setInterrupt(true); // turn off LED
+        enable |= TCS_AIEN;
+    }
+
+    //Toggling ADC enable clears the valid flag, integration time follows enable register
+    uint8_t values[2] = {(uint8_t) (enable & ~TCS_AEN), (uint8_t) (256 - cycles)};
+    writeRegs(TCS_ENABLE, values, 2);
 
-        delay(100); // takes 50ms to read
+    enable |= TCS_PON | TCS_AEN;
+    writeRegs(TCS_ENABLE, &enable, 1);
 
-        tcs.getRawData(r, g, b, c);
+    readStart = millis();
+    dropBurst();
+}
+
+//Forgets burst read, dropping it when it lands if it is still on the bus
+void TowerRobot::ColorSensor::dropBurst() {
+    if (burst == TWI_PENDING) {
+        stale = true;
+    } else {
+        burst = TWI_IDLE;
     }
 }
 
-void TowerRobot::ColorSensor::getReflected(int* r, int* g, int* b, int* c) {
-    //Gets ambient light values with LED off
-    int ambient[4];
-    getRaw(false, ambient, ambient+1, ambient+2, ambient+3);
+//Whether integration has completed (or timed out)
+bool TowerRobot::ColorSensor::dataValid() {
+    unsigned long elapsed = millis() - readStart;
+
+    //Skips bus reads before integration can finish (2.4 ms per cycle)
+    if ((elapsed * 5) < ((unsigned long) cycles * 12)) {
+        return false;
+    }
+
+    //Burst queued before restart holds old data
+    if (stale && (burst != TWI_PENDING)) {
+        stale = false;
+        burst = TWI_IDLE;
+    }
 
-    //Gets reflected light values with LED on
-    int reflected[4];
-    getRaw(true, reflected, reflected+1, reflected+2, reflected+3);
+    if ((burst == TWI_COMPLETE) && (data[0] & TCS_AVALID)) {
+        burst = TWI_IDLE;
+        return true;
+    }
+
+    if (elapsed >= readTimeout) {
+        dropBurst();
+        return true;
+    }
+
+    //Requests status and all channels in one burst, finishing in the background
+    if (burst != TWI_PENDING) {
+        readRegs(TCS_STATUS, data, TCS_BLOCK, &burst);
+    }
+    return false;
+}
+
+//Gets channels in (r, g, b, c) order from last burst read (c, r, g, b after status)
+void TowerRobot::ColorSensor::readChannels(int* channels) {
+    channels[0] = data[3] | (data[4] << 8);
+    channels[1] = data[5] | (data[6] << 8);
+    channels[2] = data[7] | (data[8] << 8);
+    channels[3] = data[1] | (data[2] << 8);
+}
+
+//Scales raw channels to reference integration time and gain
+void TowerRobot::ColorSensor::normalize(int* channels) {
+    long scale = (long) cycles * gains[gainIndex];
+    long ref = (long) refCycles * gains[refGain];
+
+    for (int i = 0; i < 4; i++) {
+        //Counts are unsigned 16 bit
+        channels[i] = min((long) (uint16_t) channels[i] * ref / scale, 32767L);
+    }
+}
+
+//Whether raw clear channel is near full scale
+bool TowerRobot::ColorSensor::saturated(int* channels) {
+    //Full scale is 1024 counts per cycle up to 16 bits
+    long maxCount = min(1024L * cycles, 65535L);
+    return (uint16_t) channels[3] >= maxCount * 9 / 10;
+}
+
+//Sets whether reflected reads stop once classification is confident
+void TowerRobot::ColorSensor::setAdaptive(bool active) {
+    adaptive = active;
+}
+
+//Sets confidence (percent) that ends a reflected read early
+void TowerRobot::ColorSensor::setMinConfidence(int minConfidence) {
+    this->minConfidence = minConfidence;
+}
+
+//Gets confidence (percent) of last result
+int TowerRobot::ColorSensor::getConfidence() {
+    return confidence;
+}
+
+//Sets whether ambient estimate is reused instead of measured every read
+void TowerRobot::ColorSensor::setAmbientModel(bool active) {
+    ambientModel = active;
+}
+
+//Sets time between scheduled ambient measurements
+void TowerRobot::ColorSensor::setAmbientPeriod(unsigned long period) {
+    ambientPeriod = period;
+}
+
+//Measures ambient light on next read
+void TowerRobot::ColorSensor::refreshAmbient() {
+    ambientValid = false;
+}
+
+//Starts reflected light read without blocking
+void TowerRobot::ColorSensor::startRead() {
+    if ((!ambientModel) || (!ambientValid) || ((millis() - ambientTime) >= ambientPeriod)) {
+        //Measures ambient light first at reference setting
+        setIntegration(refCycles, refGain);
+        restart(false);
+
+        readState = READ_AMBIENT;
+    } else {
+        //Uses ambient estimate and only measures with LED on
+        startReflected();
+    }
+}
+
+//Starts measuring with LED on from first step
+void TowerRobot::ColorSensor::startReflected() {
+    readStep = 0;
+    accumCycles = 0;
+    for (int i = 0; i < 4; i++) {
+        accum[i] = 0;
+    }
+
+    //Adaptive reads start short, fixed reads use reference setting
+    if (adaptive) {
+        setIntegration(stepCycles[0], refGain);
+    } else {
+        setIntegration(refCycles, refGain);
+    }
+    restart(true);
+
+    readState = READ_REFLECTED;
+}
+
+//Adds finished step to reflected estimate and either ends read or starts a longer step
+void TowerRobot::ColorSensor::nextStep(int* channels) {
+    //Weak signals raise gain for next step
+    bool weak = (uint16_t) channels[3] < min(1024L * cycles, 65535L) / 10;
+    normalize(channels);
+
+    //Longer steps count more since they are less noisy
+    for (int i = 0; i < 4; i++) {
+        accum[i] += (long) (channels[i] - ambient[i]) * cycles;
+    }
+    accumCycles += cycles;
 
     //Subtracts out ambient light
     for (int i = 0; i < 4; i++) {
-        reflected[i] -= ambient[i];
+        reflected[i] = accum[i] / accumCycles;
     }
+    readStep++;
 
-    *r = *(reflected);
-    *g = *(reflected+1);
-    *b = *(reflected+2);
-    *c = *(reflected+3);
+    classify(reflected, &confidence);
+    if ((!adaptive) || (confidence >= minConfidence) || (readStep >= (int) sizeof(stepCycles))) {
+        setLed(false);
+
+        /*
+        An empty slot reflects almost nothing, so its clear value is ambient drift.
+        A large drift (or negative light) means the estimate needs to be measured again
+        */
+        if ((reflected[3] <= emptyThres) && (abs(reflected[3]) > driftThres)) {
+            ambientValid = false;
+        }
+
+        readState = READ_DONE;
+    } else {
+        setIntegration(stepCycles[readStep], (weak && (gainIndex < 3)) ? gainIndex + 1 : gainIndex);
+        restart(true);
+    }
+}
+
+//Advances read and returns whether result is ready
+bool TowerRobot::ColorSensor::poll() {
+    if ((readState == READ_AMBIENT) && dataValid()) {
+        readChannels(ambient);
+        normalize(ambient);
+
+        //Updates ambient estimate
+        ambientValid = true;
+        ambientTime = millis();
+
+        //Measures with LED on next
+        startReflected();
+    } else if ((readState == READ_REFLECTED) && dataValid()) {
+        int channels[4];
+        readChannels(channels);
+
+        if (saturated(channels) && (gainIndex > 0)) {
+            //Repeats step at lower gain
+            setIntegration(cycles, gainIndex - 1);
+            restart(true);
+        } else {
+            nextStep(channels);
+        }
+    }
+
+    return readState == READ_DONE;
+}
+
+//Whether a read is in progress
+bool TowerRobot::ColorSensor::isReading() {
+    return (readState == READ_AMBIENT) || (readState == READ_REFLECTED);
+}
+
+//Gets reflected values of last read
+void TowerRobot::ColorSensor::result(int* r, int* g, int* b, int* c) {
+    *r = reflected[0];
+    *g = reflected[1];
+    *b = reflected[2];
+    *c = reflected[3];
+}
+
+//Gets block color of last read
+int TowerRobot::ColorSensor::result() {
+    return classify(reflected);
+}
+
+void TowerRobot::ColorSensor::getRaw(bool led, int* r, int*g, int*b, int* c) {
+    //Raw values are taken at reference setting
+    setIntegration(refCycles, refGain);
+
+    //Whether LED is on or off
+    restart(led);
+
+    //Waits for integration to finish
+    while (!dataValid()) {
+
+    }
+
+    int channels[4];
+    readChannels(channels);
+    
+    //Turns LED off
+    setLed(false);
+
+    *r = channels[0];
+    *g = channels[1];
+    *b = channels[2];
+    *c = channels[3];
+}
+
+void TowerRobot::ColorSensor::getReflected(int* r, int* g, int* b, int* c) {
+    startRead();
+    while (!poll()) {
+
+    }
+    result(r, g, b, c);
 }
 
 int TowerRobot::ColorSensor::getBlockColor() {
-    //Gets raw reading with channels in array
-    int c;
-    int channels[3];
-    getReflected(channels, channels+1, channels+2, &c);
+    startRead();
+    while (!poll()) {
+
+    }
+    return result();
+}
 
+//Gets closest block color to reflected channels
+int TowerRobot::ColorSensor::classify(int* channels) {
+    int confidence;
+    return classify(channels, &confidence);
+}
+
+//Gets chromaticity distance to color
+long TowerRobot::ColorSensor::chromaDiff(int color, int red, int green) {
+    return abs(chroma[color][0] - red) + abs(chroma[color][1] - green);
+}
+
+//Gets closest block color by chromaticity and intensity, and confidence (percent) of choice
+int TowerRobot::ColorSensor::classify(int* channels, int* confidence) {
     //Checks empty threshold
-    if (c > emptyThres) {
-        //Scales rgb values
+    if (channels[3] > emptyThres) {
+        //Intensity and chromaticity of read
+        long sum = max((long) channels[0] + channels[1] + channels[2], 1L);
+        int red = 256L * channels[0] / sum;
+        int green = 256L * channels[1] / sum;
 
-        //Minimum color difference
-        float minDiff = 0;
+        //Least and second least chromaticity difference
+        long minDiff = 0;
+        long nextDiff = 0;
 
-        //Color with least difference
-        float minColor = 0;
+        //Color with least difference (black stands for both neutral colors)
+        int minColor = 0;
 
         //Checks each color
         for (int col = 0; col < numColors(); col++) {
-            //Sums each squared channel difference
-            int currDiff = 0;
-            for (int ch = 0; ch < 3; ch++) {
-                currDiff += abs(blockColors[col][ch] - channels[ch]);
+            long currDiff;
+            if (col == WHITE) {
+                continue;
+            } else if (col == BLACK) {
+                currDiff = min(chromaDiff(BLACK, red, green), chromaDiff(WHITE, red, green));
+            } else {
+                currDiff = chromaDiff(col, red, green);
             }
 
-            //Updates closest color
-            if ((currDiff < minDiff) || (col == 0)) {
+            //Updates closest two colors
+            if ((currDiff < minDiff) || (col == BLACK)) {
+                nextDiff = minDiff;
                 minDiff = currDiff;
                 minColor = col;
+            } else if ((currDiff < nextDiff) || (nextDiff == 0)) {
+                nextDiff = currDiff;
             }
         }
 
+        //Margin between closest colors
+        *confidence = (nextDiff > 0) ? (nextDiff - minDiff) * 100 / nextDiff : 100;
+
+        //Intensity splits neutral colors
+        if (minColor == BLACK) {
+            long split = labs(sum - neutralThres) * 100 / max(sum, neutralThres);
+            *confidence = min((long) *confidence, split);
+
+            minColor = (sum >= neutralThres) ? WHITE : BLACK;
+        }
+
+        //Reads just above empty threshold are unsure either way
+        *confidence = min(*confidence, (int) ((long) (channels[3] - emptyThres) * 100 / channels[3]));
+
         //Returns closest color
         return minColor;
     } else {
+        //Margin below empty threshold
+        *confidence = (channels[3] > 0) ? (long) (emptyThres - channels[3]) * 100 / emptyThres : 100;
         return EMPTY;
     }
 }
@@ -17,6 +17,16 @@ void TowerRobot::Gripper::begin() {
   servo.attach(gripPin);
 }
 
+//Gets servo position for open or closed state
+int TowerRobot::Gripper::getGripPos(bool openState) {
+  return gripPos[openState ? 0 : 1];
+}
+
+//Sets servo position for open or closed state
+void TowerRobot::Gripper::setGripPos(bool openState, int pos) {
+  gripPos[openState ? 0 : 1] = pos;
+}
+
 //Opens gripper
 void TowerRobot::Gripper::open() {
   setOpen(true);
@@ -0,0 +1,75 @@
+/*
+  IRLine.cpp - Encodes and decodes 32 bit frames in a compact pulse distance line protocol
+*/
+
+#include <Arduino.h>
+#include "IRLine.h"
+
+//Whether measured duration is within half a unit of expected
+bool IRLine::within(uint16_t duration, uint16_t expected) {
+    return (duration + IR_LINE_UNIT/2 > expected) && (duration < expected + IR_LINE_UNIT/2);
+}
+
+//Fills alternating mark and space durations (us) of frame, returns number of durations
+uint8_t IRLine::encode(uint32_t frame, uint16_t* durations) {
+    uint8_t length = 0;
+    durations[length++] = IR_LINE_HEADER_MARK;
+    durations[length++] = IR_LINE_HEADER_SPACE;
+
+    for (int i = 0; i < IR_LINE_SYMBOLS; i++) {
+        //Space of n + 1 units carries symbol n
+        uint8_t symbol = (frame >> (i*2)) & 0x3;
+        durations[length++] = IR_LINE_UNIT;
+        durations[length++] = (symbol + 1) * IR_LINE_UNIT;
+    }
+
+    //Stop mark ends last space
+    durations[length++] = IR_LINE_UNIT;
+    return length;
+}
+
+//Decodes frame from measured mark and space durations (us) starting at header mark
+bool IRLine::decode(const uint16_t* durations, uint8_t length, uint32_t* frame) {
+    if (length < IR_LINE_LENGTH) {
+        return false;
+    }
+
+    //Receivers stretch marks and shorten spaces, so header is checked loosely
+    if ((!within(durations[0], IR_LINE_HEADER_MARK)) || (!within(durations[1], IR_LINE_HEADER_SPACE))) {
+        return false;
+    }
+
+    uint32_t decoded = 0;
+    for (int i = 0; i < IR_LINE_SYMBOLS; i++) {
+        uint16_t mark = durations[2 + i*2];
+        uint16_t space = durations[3 + i*2];
+
+        if (!within(mark, IR_LINE_UNIT)) {
+            return false;
+        }
+
+        //Rounds space to nearest whole unit
+        uint8_t units = (space + IR_LINE_UNIT/2) / IR_LINE_UNIT;
+        if ((units < 1) || (units > 4)) {
+            return false;
+        }
+
+        decoded |= (uint32_t) (units - 1) << (i*2);
+    }
+
+    if (!within(durations[IR_LINE_LENGTH - 1], IR_LINE_UNIT)) {
+        return false;
+    }
+
+    *frame = decoded;
+    return true;
+}
+
+//Gets airtime of frame (us)
+unsigned long IRLine::airtime(uint32_t frame) {
+    unsigned long time = IR_LINE_HEADER_MARK + IR_LINE_HEADER_SPACE + IR_LINE_UNIT;
+    for (int i = 0; i < IR_LINE_SYMBOLS; i++) {
+        time += IR_LINE_UNIT + (((frame >> (i*2)) & 0x3) + 1) * IR_LINE_UNIT;
+    }
+    return time;
+}
@@ -0,0 +1,41 @@
+/*
+  IRLine.h - Encodes and decodes 32 bit frames in a compact pulse distance line protocol
+*/
+
+#ifndef IRLine_h
+#define IRLine_h
+
+#include <Arduino.h>
+
+/*
+Each symbol is a fixed mark followed by a space 1 to 4 units long, carrying 2 bits.
+A frame is a header, 16 symbols (lowest bits first) and a stop mark
+*/
+
+//Mark length and space step (us)
+#define IR_LINE_UNIT 350
+
+//Header mark and space (us)
+#define IR_LINE_HEADER_MARK 1400
+#define IR_LINE_HEADER_SPACE 700
+
+//Symbols per frame
+#define IR_LINE_SYMBOLS 16
+
+//Durations per frame (header, mark and space per symbol, stop mark)
+#define IR_LINE_LENGTH 35
+
+//Longest frame airtime (ms)
+#define IR_LINE_FRAME_TIME 31
+
+class IRLine {
+    private:
+        static bool within(uint16_t duration, uint16_t expected);
+    public:
+        static uint8_t encode(uint32_t frame, uint16_t* durations);
+        static bool decode(const uint16_t* durations, uint8_t length, uint32_t* frame);
+
+        static unsigned long airtime(uint32_t frame);
+};
+
+#endif
@@ -9,6 +9,7 @@
 #include <IRremote.hpp>
 
 using namespace IRcommands;
+using namespace Message;
 
 TowerRobot::IRT::IRT(int address, int sendPin, int recvPin) {
     //Initializes ir send and recieve pins
@@ -17,6 +18,17 @@ TowerRobot::IRT::IRT(int address, int sendPin, int recvPin) {
 
     //Sets communication id
     this->address = address;
+
+    //Nothing received or measured yet
+    for (int i = 0; i < IR_PEERS; i++) {
+      peers[i].seen.clear();
+      peers[i].quality = IR_QUALITY_START;
+      peers[i].measured = false;
+      peers[i].known = false;
+      peers[i].active = false;
+      peers[i].heard = 0;
+      peers[i].received = 0;
+    }
 }
 
 //Initializes transceiver
@@ -30,74 +42,291 @@ int TowerRobot::IRT::getAddress() {
   return address;
 }
 
+//Sets address
+void TowerRobot::IRT::setAddress(int address) {
+  this->address = address;
+}
+
 //Turns sending on and off
 void TowerRobot::IRT::setSendActive(bool active) {
   sendActive = active;
 }
 
 //Sends command without data
-void TowerRobot::IRT::send(unsigned int address, unsigned int command) {
-  send(address, command, 0);
+bool TowerRobot::IRT::send(unsigned int address, unsigned int command) {
+  return send(address, command, 0);
 }
 //Sends command with data
-void TowerRobot::IRT::send(unsigned int address, unsigned int command, unsigned int data) {
-  //Sets command data
-  sendCommand = data;
-
-  //Compiles address components in array
-  unsigned int bitArr[2] = {address, command};
-  
-  //Resets signal and bit count
-  unsigned int currBits = 0;
-  sendAddress = 0;
-  
-  //Builds signal from right to left
-  for (int i = 1; i >=0; i--) {
-    //Adds current component shifted by current base
-    sendAddress |= bitArr[i]<<currBits;
-
-    //Increments base by bits taken up by component
-    currBits += bitMap[i];
-  }
-  
-  //Sets defaults for sending
-  currInterval = 0;
-  setInterval = 0;
-
-  currRepeats = 0;
-  sendRepeats = 1;
-
-  sendActive = true;
-  interrupt = false;
-}
-
-//Sets interval between repeats
+bool TowerRobot::IRT::send(unsigned int address, unsigned int command, unsigned int data) {
+  return send(address, command, data, PRIORITY_NORMAL);
+}
+//Sends command with data at priority
+bool TowerRobot::IRT::send(unsigned int address, unsigned int command, unsigned int data, int priority) {
+  //Repeats enough for link to receiver, unless sending until replaced
+  int repeats = sendRepeats;
+  if (adaptiveRepeats && (sendRepeats > 0)) {
+    repeats = linkRepeats(address);
+  }
+
+  return send(address, command, data, priority, repeats, setInterval);
+}
+//Sends command with data, priority and its own repeats (returns false if queue is full of more important frames)
+bool TowerRobot::IRT::send(unsigned int address, unsigned int command, unsigned int data, int priority, int repeats, int interval) {
+  return queueNew(address, command, data, priority, repeats, interval, sendHops, false);
+}
+
+//Sends command with data, resending until receiver acknowledges it
+bool TowerRobot::IRT::sendAcked(unsigned int address, unsigned int command, unsigned int data) {
+  return sendAcked(address, command, data, PRIORITY_NORMAL);
+}
+//Sends command with data at priority, resending until receiver acknowledges it
+bool TowerRobot::IRT::sendAcked(unsigned int address, unsigned int command, unsigned int data, int priority) {
+  //Every robot would answer a master address frame
+  if (address == MASTER_ADDRESS) {
+    return send(address, command, data, priority);
+  }
+
+  //Sent once per try so each answer measures a single send
+  return queueNew(address, command, data, priority, 1, 0, sendHops, true);
+}
+
+//Queues new frame from this transceiver
+bool TowerRobot::IRT::queueNew(unsigned int address, unsigned int command, unsigned int data, int priority, int repeats, int interval, int hops, bool ack) {
+  //Each new frame gets next sequence number (skipping unnumbered 0), repeats share it
+  uint8_t sequence = 0;
+  if (numbered) {
+    sendSequence = (sendSequence % Sequence::limit()) + 1;
+    sequence = sendSequence;
+  }
+
+  uint32_t frame = Message::frame(address, command, this->address, sequence, hops, data) | AckRequest::encode(ack);
+  if (!queue(frame, priority, repeats, interval)) {
+    return false;
+  }
+
+  sendQueue[lastQueued].retries = ack ? ackRetries : 0;
+  return true;
+}
+
+//Queues whole frame
+bool TowerRobot::IRT::queue(uint32_t frame, int priority, int repeats, int interval) {
+  //Replaces queued frame with same destination, command and origin (relays never replace own frames)
+  uint32_t key = Dest::mask() | Command::mask() | Source::mask();
+  int index = -1;
+  for (int i = 0; i < numQueued; i++) {
+    if ((sendQueue[i].frame & key) == (frame & key)) {
+      index = i;
+    }
+  }
+
+  if (index < 0) {
+    if (numQueued >= IR_SEND_QUEUE) {
+      //Drops oldest frame of lowest priority if it is less important
+      int lowest = 0;
+      for (int i = 1; i < numQueued; i++) {
+        if (sendQueue[i].priority < sendQueue[lowest].priority) {
+          lowest = i;
+        }
+      }
+      if (sendQueue[lowest].priority >= priority) {
+        //Nothing queued now for setInterrupt to mark
+        lastQueued = -1;
+        return false;
+      }
+      removeFrame(lowest);
+    }
+
+    index = numQueued;
+    numQueued++;
+  }
+
+  //Frame is due right away
+  sendQueue[index].frame = frame;
+  sendQueue[index].priority = priority;
+  sendQueue[index].repeats = repeats;
+  sendQueue[index].interval = interval;
+  sendQueue[index].lastSend = millis() - interval;
+  sendQueue[index].interruptible = false;
+  sendQueue[index].retries = 0;
+
+  lastQueued = index;
+  return true;
+}
+
+//Removes frame from send queue, keeping order of the rest
+void TowerRobot::IRT::removeFrame(int index) {
+  for (int i = index; i < numQueued - 1; i++) {
+    sendQueue[i] = sendQueue[i + 1];
+  }
+  numQueued--;
+
+  if (lastQueued == index) {
+    lastQueued = -1;
+  } else if (lastQueued > index) {
+    lastQueued--;
+  }
+}
+
+//Gets units of parameter values sent as a byte
+double TowerRobot::IRT::paramScale(int param) {
+  switch (param) {
+    case PARAM_IR_CYCLE:
+      return 10;
+    case PARAM_SLIDE_ACCEL:
+    case PARAM_SLIDE_MAX:
+      return 0.1;
+    default:
+      return 1;
+  }
+}
+
+//Sends parameter value to address (returns false if a single robot never acknowledged it)
+bool TowerRobot::IRT::sendParam(unsigned int address, int param, double value) {
+  //Scales value to fit in value field
+  long scaled = round(value/paramScale(param));
+  scaled = constrain(scaled, 0L, (long) Param::Value::limit());
+
+  //Parameter and value travel in one frame
+  if (!sendAcked(address, PARAM, Param::Id::encode(param) | Param::Value::encode(scaled))) {
+    return false;
+  }
+
+  return waitAcked(sendQueue[lastQueued].frame);
+}
+
+//Tells address to store its current parameters (returns false if a single robot never acknowledged it)
+bool TowerRobot::IRT::sendSave(unsigned int address) {
+  if (!sendAcked(address, PARAM, Param::Id::encode(PARAM_NONE) | Param::Save::encode(1))) {
+    return false;
+  }
+
+  return waitAcked(sendQueue[lastQueued].frame);
+}
+
+//Waits until frame leaves send queue (returns false if it asked for an ACK and was given up on instead)
+bool TowerRobot::IRT::waitAcked(uint32_t frame) {
+  if (!AckRequest::decode(frame)) {
+    waitSend();
+    return true;
+  }
+
+  ackedFrame = 0;
+  while (true) {
+    update();
+
+    bool queued = false;
+    for (int i = 0; i < numQueued; i++) {
+      if (sendQueue[i].frame == frame) {
+        queued = true;
+      }
+    }
+    if (!queued) {
+      return ackedFrame == frame;
+    }
+  }
+}
+
+//Sets interval between repeats of new frames
 void TowerRobot::IRT::setSendInterval(int interval) {
   setInterval = interval;
 }
 
-//Sets number of repeats
+//Sets number of sends of new frames (-1 sends until replaced)
 void TowerRobot::IRT::setSendRepeats(int repeats) {
   sendRepeats = repeats;
 }
 
-//Resets repeating
-void TowerRobot::IRT::resetSendRepeats() {
-  currRepeats = 0;
+//Sets whether new frames are numbered (unnumbered repeats are all received)
+void TowerRobot::IRT::setNumbered(bool active) {
+  numbered = active;
+}
+
+//Sets whether repeats of new frames follow measured link quality
+void TowerRobot::IRT::setAdaptiveRepeats(bool active) {
+  adaptiveRepeats = active;
+}
+
+//Sets resends of unacknowledged frames
+void TowerRobot::IRT::setAckRetries(int retries) {
+  ackRetries = retries;
+}
+
+//Gets percent of sends to address that are acknowledged
+int TowerRobot::IRT::getLinkQuality(unsigned int address) {
+  return peers[address % IR_PEERS].quality * 100L / 255;
+}
+
+//Gets number of acknowledged frames given up on
+unsigned int TowerRobot::IRT::getSendFailures() {
+  return sendFailures;
 }
 
-//Sets intervals
-void TowerRobot::IRT::useInterval() {
-  //Updates last send time
-  lastSend = millis();
+//Adds outcome of a send to link quality of address
+void TowerRobot::IRT::linkSample(unsigned int address, bool delivered) {
+  Peer* peer = &peers[address % IR_PEERS];
 
-  //Sets interval
-  currInterval = setInterval;
+  //Moves average a fraction of the way to the sample
+  int sample = delivered ? 255 : 0;
+  peer->quality += (sample - peer->quality) / (1 << IR_QUALITY_SHIFT);
+  peer->measured = true;
 }
 
-//Whether transceiver is currently sending
+//Gets sends needed for a frame to reach address (weakest measured link for master address)
+int TowerRobot::IRT::linkRepeats(unsigned int address) {
+  int quality = -1;
+  if (address == MASTER_ADDRESS) {
+    for (int i = 0; i < IR_PEERS; i++) {
+      if (peers[i].measured && ((quality < 0) || (peers[i].quality < quality))) {
+        quality = peers[i].quality;
+      }
+    }
+  } else if (peers[address % IR_PEERS].measured) {
+    quality = peers[address % IR_PEERS].quality;
+  }
+
+  //Keeps set repeats until link is measured
+  if (quality < 0) {
+    return sendRepeats;
+  }
+
+  //Adds sends until chance all are lost is small enough
+  unsigned int lost = 256 - quality;
+  unsigned int missed = lost;
+  int repeats = 1;
+  while ((missed > IR_MISS_TARGET) && (repeats < IR_MAX_REPEATS)) {
+    missed = missed * lost / 256;
+    repeats++;
+  }
+
+  return repeats;
+}
+
+//Gets time to wait for an acknowledgement (frame and answer may each wait a whole channel round per relay)
+unsigned long TowerRobot::IRT::ackTimeout() {
+  return roundTime() * (2 * sendHops + 1) + 2 * getFrameTime();
+}
+
+//Removes acknowledged frame from send queue
+void TowerRobot::IRT::acknowledge(unsigned int source, unsigned int sequence) {
+  for (int i = numQueued - 1; i >= 0; i--) {
+    uint32_t frame = sendQueue[i].frame;
+    if (AckRequest::decode(frame) && (Dest::decode(frame) == source) && (Sequence::decode(frame) == sequence)) {
+      linkSample(source, true);
+      ackedFrame = frame;
+      removeFrame(i);
+    }
+  }
+}
+
+//Drops all frames waiting to be sent
+void TowerRobot::IRT::cancelSend() {
+  numQueued = 0;
+  lastQueued = -1;
+}
+
+//Whether transceiver has frames left to send
 bool TowerRobot::IRT::isSending() {
-  return (currRepeats < sendRepeats);
+  return (numQueued > 0) || transmitting;
 }
 
 //Waits until done sending
@@ -112,74 +341,77 @@ void TowerRobot::IRT::setReceiveActive(bool active) {
   recvActive = active;
 }
 
-//Unpacks received signal
-void TowerRobot::IRT::unpack(unsigned int address, unsigned int command) {
-  //Address component array
-  unsigned int bitArr[2];
-
-  //Gets data
-  recvData = command;
+//Adds received frame to queue (safe to call from an interrupt)
+bool TowerRobot::IRT::push(uint32_t frame) {
+  uint8_t next = (recvHead + 1) % IR_QUEUE;
 
-  //Gets temporary copy of address
-  unsigned long temp = address;
-
-  //Unpacks components from right to left
-  for (int i = 1; i >=0; i--) {
-    //Gets component at end
-    bitArr[i] = temp & (((unsigned int) 1<<bitMap[i]) - 1);
-
-    //Removes component from end
-    temp = temp>>bitMap[i];
+  //Keeps older frames when full
+  if (next == recvTail) {
+    recvDropped++;
+    return false;
   }
 
-  //Sets components
-  recvAddress = bitArr[0];
-  recvCommand = bitArr[1];
+  recvQueue[recvHead] = frame;
+
+  //Publishes frame only once it is written
+  recvHead = next;
+  return true;
 }
 
-//Receives any signal data
+//Whether any received frame is waiting
 bool TowerRobot::IRT::receive() {
-  return recvExists;
+  return recvHead != recvTail;
 }
+//Takes oldest received frame, removing it from queue (no resume call is needed, next call reads next frame)
 bool TowerRobot::IRT::receive(unsigned int*command, unsigned int*data) {
+  unsigned int source;
+  return receive(&source, command, data);
+}
+//Takes oldest received frame with its sender
+bool TowerRobot::IRT::receive(unsigned int*source, unsigned int*command, unsigned int*data) {
   //Ensures signal is availiable
-  if (recvExists) {
+  if (recvHead != recvTail) {
     //Reads components
-    *command = recvCommand;
-    *data = recvData;
+    uint32_t frame = recvQueue[recvTail];
+    *source = Source::decode(frame);
+    *command = Command::decode(frame);
+    *data = Payload::decode(frame);
+
+    //Frees slot only once it is read
+    recvTail = (recvTail + 1) % IR_QUEUE;
 
     return true;
   } else {
     return false;
   }
 }
-bool TowerRobot::IRT::receive(unsigned int*address, unsigned int*command, unsigned int*data) {
-  //Ensures signal is availiable
-  if (recvExists) {
-    //Reads components
-    *address = recvAddress;
-    *command = recvCommand;
-    *data = recvData;
 
-    return true;
-  } else {
-    return false;
-  }
+//Gets number of frames lost to a full queue
+unsigned int TowerRobot::IRT::getDropped() {
+  return recvDropped;
+}
+
+//Gets number of frames lost to receiver buffer overflow
+unsigned int TowerRobot::IRT::getOverflows() {
+  return recvOverflows;
 }
 
-// Clears received data
-void TowerRobot::IRT::resume() {
-  recvExists = false;
+//Resets lost frame counts
+void TowerRobot::IRT::resetDropped() {
+  recvDropped = 0;
+  recvOverflows = 0;
 }
 
-//Sets receive interrupt
+//Lets a received frame cancel last queued frame
 void TowerRobot::IRT::setInterrupt() {
-  interrupt = true;
+  if (lastQueued >= 0) {
+    sendQueue[lastQueued].interruptible = true;
+  }
 }
 
 //Waits until something is received
 void TowerRobot::IRT::waitReceive() {
-  while (!recvExists) {
+  while (!receive()) {
     update();
   }
 }
@@ -187,76 +419,281 @@ void TowerRobot::IRT::waitReceive() {
 //Waits until received or timeout
 bool TowerRobot::IRT::waitReceive(int timeout) {
   unsigned long timeoutStart = millis();
-  while ((!recvExists) && ((millis() - timeoutStart) < timeout)) {
+  while ((!receive()) && ((millis() - timeoutStart) < (unsigned long) timeout)) {
     update();
   }
 
-  return recvExists;
+  return receive();
 }
 
-//Sets whether non-directed signals are relayed
+//Sets whether signals for other addresses are relayed
 void TowerRobot::IRT::setAutoRelay(bool active) {
   autoRelay = active;
 }
 
+//Sets relays allowed for new frames (up to 3, same on every robot so relayed copies can be told apart)
+void TowerRobot::IRT::setSendHops(int hops) {
+  sendHops = constrain(hops, 0, (int) Hops::limit());
+}
+
+//Whether frame was heard from a relay (new frames leave with send hops, ACKs with all, and every relay takes one)
+bool TowerRobot::IRT::relayed(uint32_t frame) {
+  unsigned int hops = (Command::decode(frame) == ACK) ? Hops::limit() : sendHops;
+  return Hops::decode(frame) < hops;
+}
+
 //Updates sending and receiving actions
 void TowerRobot::IRT::update() {
+  //Hands Timer2 back to receiver once background frame is out
+  if (transmitting && (!IRTransmitter::busy())) {
+    transmitting = false;
+    lastSend = millis();
+    IrReceiver.start();
+  }
+
   //Updates recieved signal
-  if (recvActive && IrReceiver.decode()) {
+  if (recvActive && (!transmitting) && IrReceiver.decode()) {
     //Ensures protocol is correct and is not interfering with sending
-    if ((IrReceiver.decodedIRData.protocol == NEC) && (!(IrReceiver.decodedIRData.flags & IRDATA_FLAGS_WAS_OVERFLOW)) && ((millis() - lastSend) >= sheildTime)) {
-      //Unpacks signal
-      unpack(IrReceiver.decodedIRData.address, IrReceiver.decodedIRData.command);
+    uint32_t frame;
+    if (readFrame(&frame) && ((millis() - lastSend) >= sheildTime)) {
+      unsigned int dest = Dest::decode(frame);
 
       IrReceiver.resume();
       
-      //Determines whether signal is addressed or has master address
-      recvExists = (recvAddress == address) || (recvAddress == MASTER_ADDRESS);
+      //Ignores reflections of own frames
+      bool own = (Source::decode(frame) == address);
+
+      //Whether frame is not a repeat or late copy of one from its source, forgetting sources heard long ago as they may have restarted numbering
+      bool fresh = false;
+      if (!own) {
+        Peer* origin = &peers[Source::decode(frame)];
+        uint16_t now = millis() >> 4;
+        if ((uint16_t) (now - origin->received) > (IR_SEQUENCE_EXPIRE >> 4)) {
+          origin->seen.clear();
+        }
+        origin->received = now;
+        fresh = origin->seen.first(Sequence::decode(frame));
+      }
 
-      if (recvExists) {
-        //Normalizes time channel
-        syncChannel(IR_CYCLE);
+      //Any robot heard directly holds a dynamic slot (frames sent in a slot line up own slots, joins may be late)
+      //Relayed copies went out in the relay's slot, so their origin may be out of sight
+      if ((!own) && (!relayed(frame))) {
+        if (dynamicSlots && (!clockSync) && peers[Source::decode(frame)].active) {
+          alignSlots(frame);
+        }
+        hear(Source::decode(frame));
+      }
 
-        //Stops sending if recieve interrupt exists
-        if (interrupt) {
-          setSendRepeats(0);
+      //Keeps signal if addressed or has master address
+      if ((!own) && ((dest == address) || (dest == MASTER_ADDRESS))) {
+        unsigned int source = Source::decode(frame);
+        unsigned int sequence = Sequence::decode(frame);
+
+        if (Command::decode(frame) == ACK) {
+          if (dest == address) {
+            acknowledge(source, Ack::Sequence::decode(Payload::decode(frame)));
+          }
+        } else if (Command::decode(frame) == BEACON) {
+          //Relayed stamps are late by however long the relay queued them
+          if (!relayed(frame)) {
+            readBeacon(frame);
+          }
+        } else {
+          //Answers every copy in case an earlier ACK was lost (as far back as any relayed frame came)
+          if ((dest == address) && AckRequest::decode(frame)) {
+            queueNew(source, ACK, Ack::Sequence::encode(sequence), PRIORITY_HIGH, 1, 0, Hops::limit(), false);
+          }
+
+          //Keeps frame only once, even if a late copy comes after newer frames from its source
+          if (fresh) {
+            push(frame);
+          }
+
+          //Stops sending frames that wait on a reply
+          for (int i = numQueued - 1; i >= 0; i--) {
+            if (sendQueue[i].interruptible) {
+              removeFrame(i);
+            }
+          }
         }
-      } else if (autoRelay) {
-        //Auto relays non-directed commands
-        send(recvAddress, recvCommand, recvData);
-        waitSend();
+
+        //Normalizes time channel
+        if ((!dynamicSlots) && (!clockSync)) {
+          syncChannel(cycle);
+        }
+      }
+
+      //Relays numbered frames for others with hops left once each, behind own frames and in own time channel
+      if ((!own) && autoRelay && (dest != address) && (Hops::decode(frame) > 0) && (Sequence::decode(frame) != 0) && fresh) {
+        queue((frame & ~Hops::mask()) | Hops::encode(Hops::decode(frame) - 1), PRIORITY_LOW, 1, 0);
       }
     } else {
+      //Counts frames lost to receiver buffer overflow
+      if (IrReceiver.decodedIRData.flags & IRDATA_FLAGS_WAS_OVERFLOW) {
+        recvOverflows++;
+      }
+
       IrReceiver.resume();
     }
   }
 
-  //Sends data
-  if (sendActive) {
-    //Checks to see if there are still repeats left and interval is reached
-    if (((currRepeats < sendRepeats) || (sendRepeats == -1)) && ((millis() - lastSend) >= currInterval)) {
-      //Sets send repeats to zero to avoid recursion
-      int hold = sendRepeats;
-      sendRepeats = 0;
+  //Frees slots of robots that went quiet
+  releaseSlots();
+
+  //Becomes clock reference when reference robot goes quiet, sending beacons while reference
+  if (clockSync) {
+    if ((clockSource != MASTER_ADDRESS) && ((millis() - lastBeacon) > (unsigned long) IR_BEACON_INTERVAL * IR_BEACON_MISSES)) {
+      clockSource = MASTER_ADDRESS;
+    }
+
+    if ((clockSource == MASTER_ADDRESS) && ((millis() - lastBeacon) >= IR_BEACON_INTERVAL)) {
+      queue(Message::frame(MASTER_ADDRESS, BEACON, address, 0, 0), PRIORITY_HIGH, 1, 0);
+      lastBeacon = millis();
+    }
+  }
+
+  //Resends or gives up on frames left unacknowledged
+  for (int i = numQueued - 1; i >= 0; i--) {
+    if ((sendQueue[i].repeats == 0) && ((millis() - sendQueue[i].lastSend) >= ackTimeout())) {
+      linkSample(Dest::decode(sendQueue[i].frame), false);
+
+      if (sendQueue[i].retries > 0) {
+        sendQueue[i].retries--;
+        sendQueue[i].repeats = 1;
+      } else {
+        sendFailures++;
+        removeFrame(i);
+      }
+    }
+  }
+
+  //Sends data while a whole frame fits in own time channel
+  if (sendActive && (!transmitting) && (numQueued > 0) && inChannel(getFrameTime())) {
+    //Picks due frame with highest priority, oldest first (frames waiting on an ACK are not due)
+    int next = -1;
+    for (int i = 0; i < numQueued; i++) {
+      if ((sendQueue[i].repeats != 0) && ((millis() - sendQueue[i].lastSend) >= (unsigned long) sendQueue[i].interval) && ((next < 0) || (sendQueue[i].priority > sendQueue[next].priority))) {
+        next = i;
+      }
+    }
+
+    if (next >= 0) {
+      //Stamps beacons as they go out
+      if (Command::decode(sendQueue[next].frame) == BEACON) {
+        sendQueue[next].frame = (sendQueue[next].frame & ~Payload::mask()) | Payload::encode(Beacon::Time::encode(getNetworkTime()));
+      }
 
-      //Waits for channel and sends if not interrupted
-      waitChannel(numChannels, IR_CYCLE);
-      if (!(interrupt && recvExists)) {
-        IrSender.sendNEC(sendAddress, sendCommand, 0);
+      sendFrame(sendQueue[next].frame);
 
-        //Resets
-        sendRepeats = hold;
+      lastSend = millis();
+      sendQueue[next].lastSend = lastSend;
 
-        //Sets interval
-        useInterval();
+      //Sending holds own dynamic slot
+      hear(address);
 
-        //Increments repeats
-        currRepeats++;
+      //Removes frame after last repeat, unless it waits on an ACK
+      if (sendQueue[next].repeats > 0) {
+        sendQueue[next].repeats--;
+        if ((sendQueue[next].repeats == 0) && (!AckRequest::decode(sendQueue[next].frame))) {
+          removeFrame(next);
+        }
       }
     }
   }
 }
 
+//Gets frame from decoded signal in current line protocol
+bool TowerRobot::IRT::readFrame(uint32_t* frame) {
+  if (IrReceiver.decodedIRData.flags & IRDATA_FLAGS_WAS_OVERFLOW) {
+    return false;
+  }
+
+  if (protocol == IR_PROTOCOL_LINE) {
+    //Converts raw ticks after leading gap to microseconds
+    irparams_struct* raw = IrReceiver.decodedIRData.rawDataPtr;
+    uint8_t length = min(raw->rawlen - 1, IR_LINE_LENGTH);
+
+    uint16_t durations[IR_LINE_LENGTH];
+    for (int i = 0; i < length; i++) {
+      durations[i] = raw->rawbuf[i + 1] * MICROS_PER_TICK;
+    }
+
+    return IRLine::decode(durations, length, frame);
+  } else {
+    //32 bit frames decode as NEC, or ONKYO if command byte is not inverted
+    decode_type_t type = IrReceiver.decodedIRData.protocol;
+    *frame = IrReceiver.decodedIRData.decodedRawData;
+    return (type == NEC) || (type == ONKYO);
+  }
+}
+
+//Sends frame in current line protocol
+void TowerRobot::IRT::sendFrame(uint32_t frame) {
+  //Sends in background when carrier pin is used, so motors keep stepping
+  if (sendPin == IR_CARRIER_PIN) {
+    const IRTransmitter::Timing* timing = (protocol == IR_PROTOCOL_LINE) ? &IRTransmitter::LINE_TIMING : &IRTransmitter::NEC_TIMING;
+
+    //Receiver gives up Timer2 until frame is out
+    IrReceiver.stop();
+    if (IRTransmitter::send(frame, timing)) {
+      transmitting = true;
+      return;
+    }
+    IrReceiver.start();
+  }
+
+  if (protocol == IR_PROTOCOL_LINE) {
+    uint16_t durations[IR_LINE_LENGTH];
+    uint8_t length = IRLine::encode(frame, durations);
+    IrSender.sendRaw(durations, length, 38);
+  } else {
+    IrSender.sendNECRaw(frame, 0);
+  }
+}
+
+//Whether own time channel stays open for duration
+bool TowerRobot::IRT::inChannel(unsigned long duration) {
+  //Robots only share low bits of network time, so channels restart when it wraps and frames never straddle the wrap
+  if (clockSync && (channelTime() + duration > Beacon::Time::limit() + 1)) {
+    return false;
+  }
+
+  if (dynamicSlots) {
+    unsigned long elapsed = channelTime();
+    unsigned long round = roundTime();
+    unsigned long slot = getSlotTime();
+
+    //Robots without a slot join in slot 0, backing off by number of robots that could also be joining
+    int own = slotIndex(address);
+    if (own == 0) {
+      if (elapsed/round != joinRound) {
+        int waiting = 1;
+        for (int i = 0; i < IR_PEERS; i++) {
+          if (peers[i].known && (!peers[i].active) && ((unsigned int) i != address)) {
+            waiting++;
+          }
+        }
+
+        joinRound = elapsed/round;
+        joining = (random(max(waiting, IR_JOIN_BACKOFF)) == 0);
+      }
+      if (!joining) {
+        return false;
+      }
+    }
+
+    return ((elapsed % round)/slot == (unsigned long) own) && ((elapsed % slot) + duration <= slot);
+  }
+
+  if (numChannels <= 1) {
+    return true;
+  }
+
+  unsigned long elapsed = channelTime();
+  bool own = ((elapsed/cycle) % numChannels) == (address % numChannels);
+  return own && ((elapsed % cycle) + duration <= (unsigned long) cycle);
+}
+
 //Synchronizes robots
 void TowerRobot::IRT::synchronize() {
   //Sends ready signal
@@ -264,6 +701,205 @@ void TowerRobot::IRT::synchronize() {
   waitSend();
 }
 
+//Marks address as heard, giving it a dynamic slot
+void TowerRobot::IRT::hear(unsigned int address) {
+  Peer* peer = &peers[address % IR_PEERS];
+  peer->known = true;
+  peer->active = true;
+  peer->heard = millis() >> 4;
+}
+
+//Releases dynamic slots of addresses not heard for a while (own slot too, once nothing is sent)
+void TowerRobot::IRT::releaseSlots() {
+  uint16_t now = millis() >> 4;
+  for (int i = 0; i < IR_PEERS; i++) {
+    if (peers[i].active && ((uint16_t) (now - peers[i].heard) > (IR_SLOT_IDLE >> 4))) {
+      peers[i].active = false;
+    }
+  }
+}
+
+//Gets dynamic slot of address in round (0 is join slot for addresses without a slot)
+int TowerRobot::IRT::slotIndex(unsigned int address) {
+  address %= IR_PEERS;
+  if (!peers[address].active) {
+    return 0;
+  }
+
+  //Active addresses take slots in address order after join slot
+  int index = 1;
+  for (unsigned int i = 0; i < address; i++) {
+    if (peers[i].active) {
+      index++;
+    }
+  }
+  return index;
+}
+
+//Gets time of a whole round of time channels
+unsigned long TowerRobot::IRT::roundTime() {
+  if (dynamicSlots) {
+    return (unsigned long) getSlotTime() * (getActiveSlots() + 1);
+  } else {
+    return (unsigned long) cycle * numChannels;
+  }
+}
+
+//Lines up dynamic slots so frame started at beginning of its sender's slot
+void TowerRobot::IRT::alignSlots(uint32_t frame) {
+  int index = slotIndex(Source::decode(frame));
+
+  //Frame ended when decoded
+  unsigned long start = millis() - frameAirtime(frame);
+
+  syncStart = start - (unsigned long) index * getSlotTime();
+}
+
+//Sets network clock from beacon, following lowest address heard
+void TowerRobot::IRT::readBeacon(uint32_t frame) {
+  unsigned int source = Source::decode(frame);
+
+  //Ignores higher addresses while own or a lower reference is alive
+  if ((clockSource == MASTER_ADDRESS) ? (source > address) : (source > clockSource)) {
+    return;
+  }
+
+  //New reference sets clock outright
+  if (source != clockSource) {
+    clockSource = source;
+    clockLocked = false;
+    clockDrift = 0;
+  }
+  lastBeacon = millis();
+
+  //Beacon was stamped when it started, so its time now is one airtime later
+  unsigned long stamp = Beacon::Time::decode(Payload::decode(frame)) + frameAirtime(frame);
+
+  //Unwraps stamp around own estimate
+  double fraction;
+  unsigned long estimate = networkTime(&fraction);
+  long wrapped = (stamp - estimate) & Beacon::Time::limit();
+  if (wrapped > (long) (Beacon::Time::limit()/2)) {
+    wrapped -= Beacon::Time::limit() + 1;
+  }
+  double error = wrapped - fraction;
+
+  //Corrects part of error now and learns drift from the rest (fractions are kept so small corrections add up)
+  double phase;
+  if (clockLocked) {
+    unsigned long elapsed = millis() - clockLocal;
+    if (elapsed > 0) {
+      clockDrift += IR_CLOCK_DRIFT_GAIN * error / elapsed;
+    }
+    phase = fraction + IR_CLOCK_PHASE_GAIN * error;
+  } else {
+    phase = fraction + error;
+    clockLocked = true;
+  }
+
+  clockNetwork = estimate + (long) floor(phase);
+  clockPhase = phase - floor(phase);
+  clockLocal = millis();
+}
+
+//Gets time into time channels (wrapped network time once clocks are synchronized)
+unsigned long TowerRobot::IRT::channelTime() {
+  if (clockSync) {
+    return getNetworkTime();
+  } else {
+    return millis() - syncStart;
+  }
+}
+
+//Sets whether time channels follow network clock kept by beacons (all robots must match)
+void TowerRobot::IRT::setClockSync(bool active) {
+  clockSync = active;
+}
+
+//Gets airtime of frame in current protocol (ms)
+unsigned long TowerRobot::IRT::frameAirtime(uint32_t frame) {
+  const IRTransmitter::Timing* timing = (protocol == IR_PROTOCOL_LINE) ? &IRTransmitter::LINE_TIMING : &IRTransmitter::NEC_TIMING;
+  return (IRTransmitter::airtime(frame, timing) + 500)/1000;
+}
+
+//Gets shared network time, wrapping at width of beacon stamps (own time until a beacon is heard)
+unsigned long TowerRobot::IRT::getNetworkTime() {
+  double fraction;
+  return networkTime(&fraction) & Beacon::Time::limit();
+}
+
+//Gets network time in whole ms and fraction of a ms
+unsigned long TowerRobot::IRT::networkTime(double* fraction) {
+  unsigned long elapsed = millis() - clockLocal;
+  double extra = elapsed * clockDrift + clockPhase;
+
+  *fraction = extra - floor(extra);
+  return clockNetwork + elapsed + (long) floor(extra);
+}
+
+//Gets how much faster network clock runs than own clock (parts per million)
+double TowerRobot::IRT::getClockDrift() {
+  return clockDrift * 1000000;
+}
+
+//Gets address whose clock is followed
+int TowerRobot::IRT::getClockSource() {
+  return (clockSource == MASTER_ADDRESS) ? address : clockSource;
+}
+
+//Sets whether time slots are given only to robots with traffic (all robots must match)
+void TowerRobot::IRT::setDynamicSlots(bool active) {
+  dynamicSlots = active;
+}
+
+//Gets length of a dynamic time slot (one frame and guard)
+int TowerRobot::IRT::getSlotTime() {
+  return getFrameTime() + IR_SLOT_GUARD;
+}
+
+//Gets number of robots holding dynamic slots
+int TowerRobot::IRT::getActiveSlots() {
+  int count = 0;
+  for (int i = 0; i < IR_PEERS; i++) {
+    if (peers[i].active) {
+      count++;
+    }
+  }
+  return count;
+}
+
+//Gets time channel size
+int TowerRobot::IRT::getCycle() {
+  return cycle;
+}
+
+//Sets time channel size (at least one frame and guard, or no frame would ever fit)
+void TowerRobot::IRT::setCycle(int cycle) {
+  this->cycle = max(cycle, getSlotTime());
+}
+
+//Gets line protocol
+int TowerRobot::IRT::getProtocol() {
+  return protocol;
+}
+
+//Sets line protocol (all robots must match)
+void TowerRobot::IRT::setProtocol(int protocol) {
+  this->protocol = protocol;
+
+  //Keeps a whole frame fitting in time channel
+  setCycle(cycle);
+}
+
+//Gets longest airtime of a frame in current protocol
+int TowerRobot::IRT::getFrameTime() {
+  if (protocol == IR_PROTOCOL_LINE) {
+    return IR_LINE_FRAME_TIME;
+  } else {
+    return IR_FRAME_TIME;
+  }
+}
+
 //Resets channel synchronization
 void TowerRobot::IRT::resetChannels() {
   syncStart = millis();
@@ -284,22 +920,25 @@ void TowerRobot::IRT::waitChannel(int channels, int size) {
   //If there are multiple channels
   if (numChannels > 1) {
     //Waits for incorrect parity
-    while (((millis() - syncStart)/size) % channels == (getAddress() % channels)) {
+    while (onChannel(channels, size)) {
       update();
-      if (interrupt && recvExists) {
-        break;
-      }
     }
     //Waits for correct parity
-    while (((millis() - syncStart)/size) % channels != (getAddress() % channels)) {
+    while (!onChannel(channels, size)) {
       update();
-      if (interrupt && recvExists) {
-        break;
-      }
     }
   }
 }
 
+//Whether own time channel is open (always with a single channel)
+bool TowerRobot::IRT::onChannel(int channels, int size) {
+  if (numChannels <= 1) {
+    return true;
+  }
+
+  return (channelTime()/size) % channels == (address % channels);
+}
+
 //Moves to middle of time channel
 void TowerRobot::IRT::syncChannel(int size) {
   unsigned long time = millis();
@@ -0,0 +1,156 @@
+/*
+  IRTransmitter.cpp - Sends infrared frames in the background with a Timer2 carrier
+*/
+
+#include <Arduino.h>
+#include "IRTransmitter.h"
+
+#if defined(__AVR__)
+#include <util/atomic.h>
+#endif
+
+//NEC: 9 ms header, 560 us marks, 1 bit per symbol
+const IRTransmitter::Timing IRTransmitter::NEC_TIMING = {9000, 4500, 560, {560, 1690, 0, 0}, 1, 32};
+
+//Line protocol: 2 bits per symbol
+const IRTransmitter::Timing IRTransmitter::LINE_TIMING = {IR_LINE_HEADER_MARK, IR_LINE_HEADER_SPACE, IR_LINE_UNIT, {IR_LINE_UNIT, 2*IR_LINE_UNIT, 3*IR_LINE_UNIT, 4*IR_LINE_UNIT}, 2, IR_LINE_SYMBOLS};
+
+uint16_t IRTransmitter::headerCycles[2];
+uint16_t IRTransmitter::markCycles;
+uint16_t IRTransmitter::spaceCycles[4];
+volatile uint32_t IRTransmitter::bits;
+uint8_t IRTransmitter::bitsPerSymbol;
+uint8_t IRTransmitter::symbolMask;
+volatile uint8_t IRTransmitter::step;
+uint8_t IRTransmitter::lastStep;
+volatile uint16_t IRTransmitter::remaining;
+volatile bool IRTransmitter::sending = false;
+
+#if defined(__AVR__)
+//Runs once per carrier cycle while sending
+ISR(TIMER2_OVF_vect) {
+    IRTransmitter::handleInterrupt();
+}
+#endif
+
+//Gets whole carrier cycles in a duration
+uint16_t IRTransmitter::cycles(uint16_t micros) {
+    return ((uint32_t) micros * IR_CARRIER_KHZ + 500) / 1000;
+}
+
+//Gets airtime of frame, which depends on its bits (us)
+unsigned long IRTransmitter::airtime(uint32_t frame, const Timing* timing) {
+    //Header, stop mark and a mark before every symbol
+    unsigned long time = timing->headerMark + timing->headerSpace + timing->mark;
+    uint8_t mask = (1 << timing->bitsPerSymbol) - 1;
+    for (int i = 0; i < timing->symbols; i++) {
+        time += timing->mark + timing->spaces[(frame >> (i*timing->bitsPerSymbol)) & mask];
+    }
+    return time;
+}
+
+//Starts sending frame, returns false if busy or not supported (Timer2 must be free)
+bool IRTransmitter::send(uint32_t frame, const Timing* timing) {
+#if defined(__AVR__)
+    if (sending) {
+        return false;
+    }
+
+    //Precomputes cycle counts so interrupt only counts down
+    headerCycles[0] = cycles(timing->headerMark);
+    headerCycles[1] = cycles(timing->headerSpace);
+    markCycles = cycles(timing->mark);
+    for (int i = 0; i < 4; i++) {
+        spaceCycles[i] = cycles(timing->spaces[i]);
+    }
+
+    bits = frame;
+    bitsPerSymbol = timing->bitsPerSymbol;
+    symbolMask = (1 << bitsPerSymbol) - 1;
+
+    //Header mark and space, mark and space per symbol, stop mark
+    lastStep = 2 + timing->symbols*2;
+
+    pinMode(IR_CARRIER_PIN, OUTPUT);
+    digitalWrite(IR_CARRIER_PIN, LOW);
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        //Phase correct PWM up to OCR2A without prescaler, one overflow per carrier cycle
+        TCCR2A = _BV(WGM20);
+        TCCR2B = _BV(WGM22) | _BV(CS20);
+        OCR2A = F_CPU / 2000 / IR_CARRIER_KHZ;
+        OCR2B = OCR2A / 3;
+        TCNT2 = 0;
+
+        //Starts with header mark
+        step = 0;
+        remaining = headerCycles[0];
+        setCarrier(true);
+        sending = true;
+
+        TIFR2 = _BV(TOV2);
+        TIMSK2 = _BV(TOIE2);
+    }
+    return true;
+#else
+    (void) frame;
+    (void) timing;
+    return false;
+#endif
+}
+
+//Whether a frame is on air
+bool IRTransmitter::busy() {
+    return sending;
+}
+
+//Connects or disconnects carrier from pin
+void IRTransmitter::setCarrier(bool on) {
+#if defined(__AVR__)
+    if (on) {
+        TCCR2A |= _BV(COM2B1);
+    } else {
+        TCCR2A &= ~_BV(COM2B1);
+    }
+#else
+    (void) on;
+#endif
+}
+
+//Releases Timer2 after last mark
+void IRTransmitter::stop() {
+#if defined(__AVR__)
+    setCarrier(false);
+    TIMSK2 = 0;
+    sending = false;
+#endif
+}
+
+//Counts down current mark or space and moves to next one
+void IRTransmitter::handleInterrupt() {
+    if (!sending) {
+        return;
+    }
+
+    remaining--;
+    if (remaining > 0) {
+        return;
+    }
+
+    step++;
+    if (step > lastStep) {
+        stop();
+    } else if (step == 1) {
+        setCarrier(false);
+        remaining = headerCycles[1];
+    } else if (step % 2 == 0) {
+        //Marks are even steps
+        setCarrier(true);
+        remaining = markCycles;
+    } else {
+        //Space length carries next symbol
+        setCarrier(false);
+        remaining = spaceCycles[bits & symbolMask];
+        bits >>= bitsPerSymbol;
+    }
+}
@@ -0,0 +1,64 @@
+/*
+  IRTransmitter.h - Sends infrared frames in the background with a Timer2 carrier
+*/
+
+#ifndef IRTransmitter_h
+#define IRTransmitter_h
+
+#include <Arduino.h>
+#include "IRLine.h"
+
+//Pin Timer2 drives the carrier on (OC2B)
+#define IR_CARRIER_PIN 3
+
+//Carrier frequency (kHz)
+#define IR_CARRIER_KHZ 38
+
+class IRTransmitter {
+    public:
+        //Mark and space lengths (us) of a pulse distance protocol
+        struct Timing {
+            uint16_t headerMark;
+            uint16_t headerSpace;
+            uint16_t mark;
+
+            //Space of each symbol value
+            uint16_t spaces[4];
+
+            uint8_t bitsPerSymbol;
+            uint8_t symbols;
+        };
+
+        static const Timing NEC_TIMING;
+        static const Timing LINE_TIMING;
+
+        static unsigned long airtime(uint32_t frame, const Timing* timing);
+
+        static bool send(uint32_t frame, const Timing* timing);
+        static bool busy();
+
+        static void handleInterrupt();
+    private:
+        //Carrier cycles of header, mark and each symbol space
+        static uint16_t headerCycles[2];
+        static uint16_t markCycles;
+        static uint16_t spaceCycles[4];
+
+        //Bits left to send, shifted down as symbols go out
+        static volatile uint32_t bits;
+        static uint8_t bitsPerSymbol;
+        static uint8_t symbolMask;
+
+        //Current mark or space and its carrier cycles left
+        static volatile uint8_t step;
+        static uint8_t lastStep;
+        static volatile uint16_t remaining;
+
+        static volatile bool sending;
+
+        static uint16_t cycles(uint16_t micros);
+        static void setCarrier(bool on);
+        static void stop();
+};
+
+#endif
@@ -0,0 +1,77 @@
+/*
+  Journal.cpp - Saves robot state in a wear-levelled EEPROM ring
+*/
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <stddef.h>
+#include "TowerRobot.h"
+#include "Utils.h"
+
+TowerRobot::Journal::Journal(int start, int slots) {
+  //Sets ring location
+  this->start = start;
+  this->slots = slots;
+}
+
+//Gets EEPROM address of record
+int TowerRobot::Journal::slotAddress(int slot) {
+  return start + slot*sizeof(State);
+}
+
+//Gets checksum of record contents
+uint8_t TowerRobot::Journal::checksum(State* state) {
+  return Utils::checksum((const uint8_t*) state, offsetof(State, checksum));
+}
+
+//Reads newest valid record
+bool TowerRobot::Journal::read(State* state) {
+  bool found = false;
+  State curr;
+
+  for (int i = 0; i < slots; i++) {
+    EEPROM.get(slotAddress(i), curr);
+
+    //Skips erased or partly written records
+    if (curr.checksum != checksum(&curr)) {
+      continue;
+    }
+
+    //Keeps newest record, allowing sequence to wrap around
+    if ((!found) || ((int16_t) (curr.sequence - state->sequence) > 0)) {
+      *state = curr;
+      found = true;
+
+      //Continues after newest record
+      nextSlot = (i + 1) % slots;
+      sequence = curr.sequence;
+    }
+  }
+
+  return found;
+}
+
+//Writes record to next slot in ring
+void TowerRobot::Journal::write(State* state) {
+  sequence++;
+  state->sequence = sequence;
+  state->checksum = checksum(state);
+
+  //Only rewrites changed bytes
+  EEPROM.put(slotAddress(nextSlot), *state);
+
+  nextSlot = (nextSlot + 1) % slots;
+}
+
+//Invalidates all records
+void TowerRobot::Journal::clear() {
+  State curr;
+  for (int i = 0; i < slots; i++) {
+    EEPROM.get(slotAddress(i), curr);
+
+    //Breaks checksum of valid records
+    if (curr.checksum == checksum(&curr)) {
+      EEPROM.update(slotAddress(i) + offsetof(State, checksum), ~curr.checksum);
+    }
+  }
+}
@@ -0,0 +1,91 @@
+/*
+  Memory.cpp - Reports static, heap and stack RAM usage
+*/
+
+#include <Arduino.h>
+#include "Memory.h"
+
+#if defined(__AVR__)
+//Linker symbols around static data and heap
+extern char __data_start;
+extern char __heap_start;
+extern char* __brkval;
+
+//Gets current top of heap
+static char* heapEnd() {
+    if (__brkval == 0) {
+        return &__heap_start;
+    } else {
+        return __brkval;
+    }
+}
+
+//Fills RAM from start up to stack pointer with paint pattern
+static void paintFrom(char* curr) {
+    char* stack = (char*) SP;
+
+    //Only paints below stack pointer to keep current frames intact
+    while (curr < stack) {
+        *curr = STACK_PAINT;
+        curr++;
+    }
+}
+
+//Paints free RAM before static data is initialized and setup runs
+void initPaint() __attribute__((naked, used, section(".init3")));
+void initPaint() {
+    //Heap is still empty, and __brkval is not zeroed until .bss is cleared
+    paintFrom(&__heap_start);
+}
+#endif
+
+//Fills RAM between heap and stack with paint pattern
+void Memory::paintStack() {
+#if defined(__AVR__)
+    paintFrom(heapEnd());
+#endif
+}
+
+//Gets bytes of initialized and zeroed static data
+int Memory::staticRam() {
+#if defined(__AVR__)
+    return &__heap_start - &__data_start;
+#else
+    return -1;
+#endif
+}
+
+//Gets bytes currently free between heap and stack
+int Memory::freeHeap() {
+#if defined(__AVR__)
+    return (char*) SP - heapEnd();
+#else
+    return -1;
+#endif
+}
+
+//Gets bytes of stack used at its deepest point
+int Memory::stackUsed() {
+#if defined(__AVR__)
+    return (RAMEND + 1) - (int) (heapEnd() + stackUnused());
+#else
+    return -1;
+#endif
+}
+
+//Gets bytes of painted RAM that the stack has never reached
+int Memory::stackUnused() {
+#if defined(__AVR__)
+    char* curr = heapEnd();
+    char* stack = (char*) SP;
+
+    //Counts paint upward until first overwritten byte
+    while ((curr < stack) && (*((uint8_t*) curr) == STACK_PAINT)) {
+        curr++;
+    }
+
+    return curr - heapEnd();
+#else
+    return -1;
+#endif
+}
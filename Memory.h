@@ -0,0 +1,27 @@
+/*
+  Memory.h - Reports static, heap and stack RAM usage
+*/
+
+#ifndef Memory_h
+#define Memory_h
+
+#include <Arduino.h>
+
+//Serial byte that requests a memory report
+#define MEMORY_REQUEST 'm'
+
+//Byte pattern painted over unused RAM
+#define STACK_PAINT 0xC5
+
+class Memory {
+    public:
+        static void paintStack();
+
+        static int staticRam();
+        static int freeHeap();
+
+        static int stackUsed();
+        static int stackUnused();
+};
+
+#endif
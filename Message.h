@@ -0,0 +1,135 @@
+/*
+  Message.h - Bit fields of infrared frames
+*/
+
+#ifndef Message_h
+#define Message_h
+
+#include <Arduino.h>
+
+//Unsigned field Width bits wide starting Offset bits into a frame
+template <uint8_t Offset, uint8_t Width>
+struct Field {
+    static_assert((Width > 0) && (Offset + Width <= 32), "Field must fit in a 32 bit frame");
+
+    //Largest value field holds
+    static constexpr uint32_t limit() {
+        return (Width == 32) ? 0xFFFFFFFFUL : ((1UL << Width) - 1);
+    }
+
+    //Bits of field in place
+    static constexpr uint32_t mask() {
+        return limit() << Offset;
+    }
+
+    //Places value in field, cutting off bits that do not fit
+    static constexpr uint32_t encode(uint32_t value) {
+        return (value & limit()) << Offset;
+    }
+
+    //Gets value of field from frame
+    static constexpr uint32_t decode(uint32_t frame) {
+        return (frame >> Offset) & limit();
+    }
+};
+
+namespace Message {
+    //Header of a frame (sent lowest bits first)
+    typedef Field<0, 4> Dest;
+    typedef Field<4, 4> Command;
+    typedef Field<8, 4> Source;
+
+    //Numbers new frames 1 to 7 so repeats can be dropped (0 is unnumbered)
+    typedef Field<12, 3> Sequence;
+
+    //Whether an addressed receiver answers with ACK
+    typedef Field<15, 1> AckRequest;
+
+    //Relays left before frame is dropped (time to live)
+    typedef Field<16, 2> Hops;
+
+    //Data carried after header
+    typedef Field<18, 14> Payload;
+
+    //Builds frame from header and payload
+    constexpr uint32_t frame(uint32_t dest, uint32_t command, uint32_t source, uint32_t sequence, uint32_t payload) {
+        return Dest::encode(dest) | Command::encode(command) | Source::encode(source) | Sequence::encode(sequence) | Payload::encode(payload);
+    }
+    constexpr uint32_t frame(uint32_t dest, uint32_t command, uint32_t source, uint32_t sequence, uint32_t hops, uint32_t payload) {
+        return frame(dest, command, source, sequence, payload) | Hops::encode(hops);
+    }
+
+    //Sequence numbers lately received from one source, so late copies of older frames are still repeats
+    struct Window {
+        //Numbers that come after the newest one and are forgotten once it arrives (the rest stay marked)
+        static constexpr uint8_t ahead = 4;
+
+        //Bit per sequence number seen (bit 0 unused)
+        uint8_t seen;
+
+        //Forgets all numbers, as source may have restarted numbering
+        void clear() {
+            seen = 0;
+        }
+
+        //Whether sequence number is new, marking it seen (unnumbered frames are always new)
+        bool first(uint8_t sequence) {
+            if (sequence == 0) {
+                return true;
+            }
+            if (seen & (1 << sequence)) {
+                return false;
+            }
+            seen |= 1 << sequence;
+
+            //Frees numbers source sends next, so window moves on with it
+            uint8_t next = sequence;
+            for (uint8_t i = 0; i < ahead; i++) {
+                next = (next % Sequence::limit()) + 1;
+                seen &= ~(1 << next);
+            }
+            return true;
+        }
+    };
+
+    //Payload of yield (LOAD, UNLOAD_TRAVEL, UNLOAD_TARGET) and DONE commands
+    namespace Yield {
+        //Tower being approached or left
+        typedef Field<0, 2> Tower;
+
+        //Whether tower is the sender's target
+        typedef Field<2, 1> ToTarget;
+
+        //Level sender needs clear (top of its cargo when unloading)
+        typedef Field<3, 5> Height;
+
+        //Time until sender reaches tower (tenths of a second)
+        typedef Field<8, 4> Eta;
+    }
+
+    //Payload of ACK command
+    namespace Ack {
+        //Sequence number of frame received
+        typedef Field<0, 3> Sequence;
+    }
+
+    //Payload of BEACON command
+    namespace Beacon {
+        //Sender's network time when frame started (ms, wraps)
+        typedef Field<0, 14> Time;
+    }
+
+    //Payload of PARAM command
+    namespace Param {
+        //Parameter set (PARAM_NONE only saves)
+        typedef Field<0, 4> Id;
+
+        //Whether parameters are stored after setting
+        typedef Field<4, 1> Save;
+
+        //Value in units of parameter's scale
+        typedef Field<5, 8> Value;
+    }
+}
+
+#endif
@@ -17,6 +17,39 @@ TowerRobot::Slide::Slide(double stepsPerBlock, double upperLimit, ScaledStepper*
   this->limit = limit;
 }
 
+//Gets steps per block
+double TowerRobot::Slide::getStepsPerBlock() {
+  return stepsPerBlock;
+}
+
+//Sets steps per block
+void TowerRobot::Slide::setStepsPerBlock(double stepsPerBlock) {
+  this->stepsPerBlock = stepsPerBlock;
+
+  //Keeps stepper speed limit in the new scale
+  stepper->setMaxSpeed(convertToRaw(defMax));
+}
+
+//Gets default acceleration
+double TowerRobot::Slide::getDefaultAccel() {
+  return defAccel;
+}
+
+//Sets default acceleration
+void TowerRobot::Slide::setDefaultAccel(double accel) {
+  defAccel = accel;
+}
+
+//Gets default max speed
+double TowerRobot::Slide::getDefaultMax() {
+  return defMax;
+}
+
+//Sets default max speed
+void TowerRobot::Slide::setDefaultMax(double max) {
+  defMax = max;
+}
+
 //Converts raw steps to blocks
 double TowerRobot::Slide::convertToBlock(double raw) {
   return raw/stepsPerBlock;
@@ -107,23 +140,59 @@ void TowerRobot::Slide::home(double homePos) {
   //Sets home position
   this->homePos = homePos;
 
-  //Uses constant slow speed
+  seekLimit();
+
+  //Homes when limit is reached
+  stepper->setCurrentPosition(convertToRaw(homePos));
+  stepper->setStepMode(8);
+}
+
+//Runs down at constant slow speed until limit is reached
+void TowerRobot::Slide::seekLimit() {
   stepper->setStepMode(16);
   stepper->setSpeed(convertToRaw(homeSpeed));
 
   while (!checkLimits()) {
     stepper->runSpeed();
   }
+}
 
-  //Homes when limit is reached
+//Sets current position without homing
+void TowerRobot::Slide::setCurrentPosition(double blockPos) {
+  stepper->setCurrentPosition(convertToRaw(blockPos));
+  targetBlockPos = round(blockPos);
+}
+
+//Checks current position against the limit switch and rehomes
+bool TowerRobot::Slide::verify() {
+  //Moves quickly to just above home
+  moveToBlock(homePos + clearMargin);
+  wait();
+
+  //Only seeks limit if it was not already hit on the way down
+  if (distanceToGo() == 0) {
+    seekLimit();
+  }
+
+  //Difference between remembered and actual position
+  double error = currentPosition() - homePos;
+
+  //Rehomes at limit
   stepper->setCurrentPosition(convertToRaw(homePos));
   stepper->setStepMode(8);
+  targetBlockPos = 0;
+
+  return (abs(error) <= verifyMargin);
 }
 
 double TowerRobot::Slide::getHomePos() {
   return homePos;
 }
 
+double TowerRobot::Slide::getUpperLimit() {
+  return upperLimit;
+}
+
 int TowerRobot::Slide::targetBlock() {
   return targetBlockPos;
 }
@@ -0,0 +1,107 @@
+/*
+  TowerModel.cpp - Tracks block colors of each tower and the cargo
+*/
+
+#include <Arduino.h>
+#include "TowerRobot.h"
+
+TowerRobot::TowerModel::TowerModel() {
+  //Starts with nothing known
+  for (int i = 0; i < numColumns(); i++) {
+    forget(i);
+  }
+}
+
+//Gets number of columns (towers and cargo)
+int TowerRobot::TowerModel::numColumns() {
+  return sizeof(known)/sizeof(known[0]);
+}
+
+//Gets color of block at level in column
+int TowerRobot::TowerModel::getColor(int column, int level) {
+  if (isKnown(column, level)) {
+    return (colors[column] >> (level*2)) & 0x3;
+  } else {
+    return UNSCANNED;
+  }
+}
+
+//Whether color at level is known
+bool TowerRobot::TowerModel::isKnown(int column, int level) {
+  if ((level < 0) || (level >= MAX_LEVELS)) {
+    return false;
+  }
+  return (known[column] >> level) & 1;
+}
+
+//Sets color of block at level
+void TowerRobot::TowerModel::setColor(int column, int level, int color) {
+  if ((level < 0) || (level >= MAX_LEVELS)) {
+    return;
+  }
+
+  if (color < 0) {
+    //Empty or unknown levels have no color
+    known[column] &= ~((uint16_t) 1 << level);
+  } else {
+    //Replaces two color bits at level
+    colors[column] &= ~((uint32_t) 0x3 << (level*2));
+    colors[column] |= (uint32_t) color << (level*2);
+    known[column] |= (uint16_t) 1 << level;
+  }
+}
+
+//Forgets all colors and height of column
+void TowerRobot::TowerModel::forget(int column) {
+  clear(column, 0);
+  setHeightKnown(column, false);
+}
+
+//Clears colors at and above level (no blocks there)
+void TowerRobot::TowerModel::clear(int column, int level) {
+  if (level <= 0) {
+    known[column] = 0;
+  } else if (level < MAX_LEVELS) {
+    known[column] &= ((uint16_t) 1 << level) - 1;
+  }
+}
+
+//Whether tower height has been confirmed
+bool TowerRobot::TowerModel::heightKnown(int tower) {
+  return (heights >> tower) & 1;
+}
+
+//Sets whether tower height has been confirmed
+void TowerRobot::TowerModel::setHeightKnown(int tower, bool state) {
+  if (tower >= CARGO_COLUMN) {
+    return;
+  }
+
+  if (state) {
+    heights |= 1 << tower;
+  } else {
+    heights &= ~(1 << tower);
+  }
+}
+
+//Moves blocks from top of one column onto another
+void TowerRobot::TowerModel::move(int from, int fromLevel, int to, int toLevel, int count) {
+  for (int i = 0; i < count; i++) {
+    setColor(to, toLevel + i, getColor(from, fromLevel + i));
+  }
+
+  //Source column no longer has blocks above start
+  clear(from, fromLevel);
+}
+
+//Moves blocks starting at level of tower into cargo
+void TowerRobot::TowerModel::load(int tower, int level, int count) {
+  clear(CARGO_COLUMN, 0);
+  move(tower, level, CARGO_COLUMN, 0, count);
+}
+
+//Moves cargo onto tower at level
+void TowerRobot::TowerModel::unload(int tower, int level, int count) {
+  clear(tower, level);
+  move(CARGO_COLUMN, 0, tower, level, count);
+}
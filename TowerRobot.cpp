@@ -4,8 +4,12 @@
 */
 
 #include <Arduino.h>
+#include <EEPROM.h>
+#include <stddef.h>
 #include "TowerRobot.h"
 
+using namespace Message;
+
 TowerRobot::TowerRobot(Slide* slide, Turret* turret, Gripper* gripper) {
 	this->slide = slide;
   this->turret = turret;
@@ -40,12 +44,21 @@ int TowerRobot::getTowerHeight(int tower) {
 
 //Begins all components
 void TowerRobot::begin() {
+  //Uses stored tuning if availiable, otherwise keeps defaults
+  loadCalibration();
+
   if (irtInit) {
     irt->begin();
   }
   if (colorInit) {
     colorSensor->begin();
   }
+
+  //Keeps holding remembered cargo through a reset
+  State state;
+  if (journal.read(&state) && (state.cargo > 0)) {
+    gripper->close();
+  }
   gripper->begin();
 }
 
@@ -54,13 +67,298 @@ void TowerRobot::home() {
   home(slide->getHomePos());
 }
 void TowerRobot::home(double homePos) {
+  journalMove();
   gripper->open();
 
   turret->home();
   slide->home(homePos);
 }
 
+//Resumes from saved state after a reset instead of rehoming and rescanning
+bool TowerRobot::resume() {
+  State state;
+  if (!journal.read(&state)) {
+    return false;
+  }
+
+  //Cargo and towers only change when a load or unload is saved, so they hold even if reset came mid-move
+  cargo = state.cargo;
+  for (int i = 0; i < 4; i++) {
+    towerHeights[i] = state.towerHeights[i];
+  }
+  model = state.model;
+
+  //Turret has no sensor to rehome, so it is taken to hold its last saved position
+  turret->home(state.turretPos);
+
+  //Slide position is only known if reset came while motors stood at saved positions
+  if (!state.moving) {
+    slide->setCurrentPosition(state.slidePos);
+  }
+
+  //A reset during the moves below is resumed the same way
+  journalMove();
+
+  if (cargo == 0) {
+    //Opens gripper to clear towers
+    gripper->open();
+    gripper->wait();
+  } else {
+    //Lifts cargo clear of tower
+    if (!state.moving) {
+      slide->moveByBlock(slide->getClearMargin());
+      slide->wait();
+    }
+
+    //Moves to carry position where slide is free to travel
+    turret->moveToCarry(turret->closestTower());
+    turret->wait();
+  }
+
+  if (state.moving) {
+    //Finds slide again at its limit, keeping any cargo gripped
+    slide->home();
+  } else if (!slide->verify()) {
+    //Checks remembered slide position against limit switch
+    return false;
+  }
+
+  //Saves verified positions
+  saveState();
+  return true;
+}
+
+//Forgets saved state so next start begins fresh
+void TowerRobot::clearState() {
+  journal.clear();
+}
+
+//Gets tuned values from all components
+void TowerRobot::getCalibration(Calibration* calib) {
+  //Starts from zeros so absent components give a stable checksum
+  memset(calib, 0, sizeof(Calibration));
+  calib->version = CALIBRATION_VERSION;
+
+  if (irtInit) {
+    calib->parts |= CALIBRATION_IRT;
+    calib->address = irt->getAddress();
+    calib->irCycle = irt->getCycle();
+  }
+
+  calib->stepsPerBlock = slide->getStepsPerBlock();
+  calib->stepsPerDegree = turret->getStepsPerDegree();
+
+  for (int i = 0; i < 4; i++) {
+    calib->towerPos[i] = turret->getTowerPos(i);
+  }
+  calib->carryOffset = turret->getCarryOffset();
+
+  calib->gripPos[0] = gripper->getGripPos(true);
+  calib->gripPos[1] = gripper->getGripPos(false);
+
+  if (colorInit) {
+    calib->parts |= CALIBRATION_COLOR;
+    calib->emptyThres = colorSensor->getEmptyThres();
+    for (int i = 0; i < 4; i++) {
+      int r, g, b;
+      colorSensor->getColorValues(i, &r, &g, &b);
+      calib->blockColors[i][0] = r;
+      calib->blockColors[i][1] = g;
+      calib->blockColors[i][2] = b;
+    }
+  }
+
+  calib->sendAngle = sendAngle;
+  calib->staggerNum = staggerNum;
+
+  calib->slideAccel = slide->getDefaultAccel();
+  calib->slideMax = slide->getDefaultMax();
+  calib->turretAccel = turret->getDefaultAccel();
+  calib->turretMax = turret->getDefaultMax();
+}
+
+//Applies tuned values to all components (optional components only if they were saved)
+void TowerRobot::setCalibration(Calibration* calib) {
+  if (irtInit && (calib->parts & CALIBRATION_IRT)) {
+    irt->setAddress(calib->address);
+    irt->setCycle(calib->irCycle);
+  }
+
+  slide->setStepsPerBlock(calib->stepsPerBlock);
+  turret->setStepsPerDegree(calib->stepsPerDegree);
+
+  for (int i = 0; i < 4; i++) {
+    turret->setTowerPos(i, calib->towerPos[i]);
+  }
+  turret->setCarryOffset(calib->carryOffset);
+
+  gripper->setGripPos(true, calib->gripPos[0]);
+  gripper->setGripPos(false, calib->gripPos[1]);
+
+  if (colorInit && (calib->parts & CALIBRATION_COLOR)) {
+    colorSensor->setEmptyThres(calib->emptyThres);
+    for (int i = 0; i < 4; i++) {
+      colorSensor->setColorValues(i, calib->blockColors[i][0], calib->blockColors[i][1], calib->blockColors[i][2]);
+    }
+  }
+
+  sendAngle = calib->sendAngle;
+  staggerNum = calib->staggerNum;
+
+  slide->setDefaultAccel(calib->slideAccel);
+  slide->setDefaultMax(calib->slideMax);
+  turret->setDefaultAccel(calib->turretAccel);
+  turret->setDefaultMax(calib->turretMax);
+}
+
+//Loads calibration from EEPROM if it is valid
+bool TowerRobot::loadCalibration() {
+  Calibration calib;
+  EEPROM.get(CALIBRATION_START, calib);
+
+  //Keeps defaults if record is from another version or corrupted
+  if ((calib.version != CALIBRATION_VERSION) || (calib.checksum != Utils::checksum((const uint8_t*) &calib, offsetof(Calibration, checksum)))) {
+    return false;
+  }
+
+  setCalibration(&calib);
+  return true;
+}
+
+//Saves current tuned values to EEPROM
+void TowerRobot::saveCalibration() {
+  Calibration calib;
+  getCalibration(&calib);
+  calib.checksum = Utils::checksum((const uint8_t*) &calib, offsetof(Calibration, checksum));
+
+  EEPROM.put(CALIBRATION_START, calib);
+}
+
+//Learns a color (or empty threshold) from a block held at sensor and stores it
+bool TowerRobot::calibrateColor(int color, int samples) {
+  if (colorInit && colorSensor->calibrate(color, samples)) {
+    saveCalibration();
+    return true;
+  }
+  return false;
+}
+
+//Gets angle to send yield signals at
+double TowerRobot::getSendAngle() {
+  return sendAngle;
+}
+
+//Sets angle to send yield signals at
+void TowerRobot::setSendAngle(double sendAngle) {
+  this->sendAngle = sendAngle;
+}
+
+//Gets runtime tunable parameter
+double TowerRobot::getParam(int param) {
+  switch (param) {
+    case PARAM_IR_CYCLE:
+      return irtInit ? irt->getCycle() : IR_CYCLE;
+    case PARAM_SEND_ANGLE:
+      return sendAngle;
+    case PARAM_STAGGER_NUM:
+      return staggerNum;
+    case PARAM_SLIDE_ACCEL:
+      return slide->getDefaultAccel();
+    case PARAM_SLIDE_MAX:
+      return slide->getDefaultMax();
+    case PARAM_TURRET_ACCEL:
+      return turret->getDefaultAccel();
+    case PARAM_TURRET_MAX:
+      return turret->getDefaultMax();
+    default:
+      return 0;
+  }
+}
+
+//Sets runtime tunable parameter
+void TowerRobot::setParam(int param, double value) {
+  //Only send angle may be zero
+  if ((value <= 0) && (param != PARAM_SEND_ANGLE)) {
+    return;
+  }
+
+  switch (param) {
+    case PARAM_IR_CYCLE:
+      if (irtInit) {
+        irt->setCycle(value);
+      }
+      break;
+    case PARAM_SEND_ANGLE:
+      sendAngle = value;
+      break;
+    case PARAM_STAGGER_NUM:
+      staggerNum = value;
+      break;
+    case PARAM_SLIDE_ACCEL:
+      slide->setDefaultAccel(value);
+      break;
+    case PARAM_SLIDE_MAX:
+      slide->setDefaultMax(value);
+      break;
+    case PARAM_TURRET_ACCEL:
+      turret->setDefaultAccel(value);
+      break;
+    case PARAM_TURRET_MAX:
+      turret->setDefaultMax(value);
+      break;
+  }
+}
+
+//Applies parameter update messages
+bool TowerRobot::updateParams(unsigned int command, unsigned int data) {
+  if (command != PARAM) {
+    return false;
+  }
+
+  //Sets parameter from scaled value
+  int param = Param::Id::decode(data);
+  if (param != PARAM_NONE) {
+    setParam(param, Param::Value::decode(data)*IRT::paramScale(param));
+  }
+
+  //Persists parameters with rest of calibration
+  if (Param::Save::decode(data)) {
+    saveCalibration();
+  }
+
+  return true;
+}
+
+//Saves state after a committed load or unload
+void TowerRobot::saveState() {
+  saveState(false);
+}
+//Saves state, marking whether motors are leaving saved positions
+void TowerRobot::saveState(bool moving) {
+  State state;
+  state.cargo = cargo;
+  state.moving = moving;
+  for (int i = 0; i < 4; i++) {
+    state.towerHeights[i] = towerHeights[i];
+  }
+  state.slidePos = slide->currentPosition();
+  state.turretPos = turret->currentPosition();
+  state.model = model;
+
+  journal.write(&state);
+  moveJournaled = moving;
+}
+
+//Records once before motors leave saved positions, so a reset mid-move is never resumed from stale positions
+void TowerRobot::journalMove() {
+  if (!moveJournaled) {
+    saveState(true);
+  }
+}
+
 bool TowerRobot::waitSlideTurret() {
+  journalMove();
+
   bool slideRun = true;
   bool turretRun = true;
   while (slideRun || turretRun) {
@@ -71,6 +369,7 @@ bool TowerRobot::waitSlideTurret() {
 
     slideRun = slide->run();
     turretRun = turret->run();
+    sampleTransit();
   }
 
   return true;
@@ -114,6 +413,8 @@ bool TowerRobot::moveToBlock(int tower) {
   return moveToBlock(tower, towerHeights[tower] - 1);
 }
 bool TowerRobot::moveToBlock(int tower, double blockNum) {
+  journalMove();
+
   if (cargo == 0) {
     //No cargo
 
@@ -136,6 +437,7 @@ bool TowerRobot::moveToBlock(int tower, double blockNum) {
         //Runs slide and turret
         slideRun = slide->run();
         turretRun = turret->run();
+        sampleTransit();
 
         //Moves turret to final position if slide is done
         if (!slideRun) {
@@ -214,6 +516,7 @@ bool TowerRobot::moveToBlock(int tower, double blockNum) {
 
           slideRun = slide->run();
           turretRun = turret->run();
+          sampleTransit();
 
           //Moves turret to final position if slide is done
           if (!slideRun) {
@@ -250,7 +553,7 @@ bool TowerRobot::moveToBlock(int tower, double blockNum) {
   return true;
 }
 
-//Loads block(s) from position on tower
+//Loads block(s) from position on tower (false if blocked or blocks stayed on tower)
 bool TowerRobot::load(int tower) {
   //Loads from top of tower as default
   return load(tower, towerHeights[tower] - 1);
@@ -273,23 +576,63 @@ bool TowerRobot::load(int tower, int blockNum) {
     if (irtInit) {
       sendYield();
 
-      sleep(IR_CYCLE);
+      sleep(irt->getCycle());
 
       if (!updateYield()) {
         return false;
       }
     }
 
-    //Closes gripper
+    //Closes gripper, gripping again before travelling if blocks stayed on tower
     gripper->close();
     gripper->wait();
+    for (int i = 0; ; i++) {
+      //Counts blocks as cargo first, so the check's swing yields like any move with cargo
+      cargo = towerHeights[tower] - blockNum;
+      model.load(tower, blockNum, cargo);
+      towerHeights[tower] -= cargo;
+
+      //Keeps cargo if blocked, as gripper may be holding it away from tower
+      bool held;
+      if (!verifyGrasp(tower, blockNum, &held)) {
+        return false;
+      }
+      if (held) {
+        break;
+      }
 
-    //Sends done signal
-    sendDone();
+      //Puts blocks back on tower, leaving it unchanged if they never came off
+      model.unload(tower, blockNum, cargo);
+      towerHeights[tower] += cargo;
+      cargo = 0;
+      if (i >= graspRetries) {
+        return false;
+      }
 
-    //Updates tower height and cargo
-    cargo = towerHeights[tower] - blockNum;
-    towerHeights[tower] -= cargo;
+      //Rises over blocks left on tower before turning back, then opens so gripper comes down around block
+      slide->moveToClear(towerHeights[tower]);
+      if (!waitSlideTurret()) {
+        return false;
+      }
+      turret->moveToTower(tower);
+      if (!waitSlideTurret()) {
+        return false;
+      }
+      gripper->open();
+      gripper->wait();
+
+      slide->moveToBlock(blockNum);
+      if (!waitSlideTurret()) {
+        return false;
+      }
+      gripper->close();
+      gripper->wait();
+    }
+
+    //Sends done signal for loaded tower (grasp check may have turned turret away)
+    sendDone(tower);
+
+    saveState();
   }
   
   return true;
@@ -306,7 +649,7 @@ bool TowerRobot::unload(int tower) {
     if (irtInit) {
       sendYield();
 
-      sleep(IR_CYCLE);
+      sleep(irt->getCycle());
 
       if (!updateYield()) {
         return false;
@@ -322,11 +665,14 @@ bool TowerRobot::unload(int tower) {
     gripper->wait();
 
     //Sends done signal
-    sendDone();
+    sendDone(tower);
 
     //Updates tower height and cargo
+    model.unload(tower, towerHeights[tower], cargo);
     towerHeights[tower] += cargo;
     cargo = 0;
+
+    saveState();
   }
 
   return true;
@@ -363,14 +709,8 @@ int TowerRobot::scanBlock(int tower, int blockNum) {
       irt->waitChannel(2, COLOR_CYCLE);
     }
 
-    int blockColor = colorSensor->getBlockColor();
-
-    //Updates tower height
-    if ((blockColor > EMPTY) && (blockNum >= towerHeights[tower])) {
-      towerHeights[tower] = blockNum + 1;
-    } else if ((blockColor == EMPTY) && (blockNum < towerHeights[tower])) {
-      towerHeights[tower] = blockNum;
-    }
+    int blockColor = senseColor();
+    recordColor(tower, blockNum, blockColor);
 
     return blockColor;
   } else {
@@ -378,6 +718,320 @@ int TowerRobot::scanBlock(int tower, int blockNum) {
   }
 }
 
+//Reads color in front of sensor, reading again while unsure
+int TowerRobot::senseColor() {
+  //Takes sensor over from any transit read
+  transitActive = false;
+
+  //Keeps most confident read
+  int blockColor = EMPTY;
+  int bestConfidence = -1;
+  for (int i = 0; (i <= rescans) && (bestConfidence < rescanConfidence); i++) {
+    colorSensor->startRead();
+    while (!colorSensor->poll()) {
+      //Keeps servicing infrared and motors during integration
+      if (irtInit) {
+        irt->update();
+      }
+      slide->run();
+      turret->run();
+    }
+
+    if (colorSensor->getConfidence() > bestConfidence) {
+      blockColor = colorSensor->result();
+      bestConfidence = colorSensor->getConfidence();
+    }
+  }
+
+  return blockColor;
+}
+
+//Checks blocks left tower after gripping by reading vacated level (held is true if confirmed or unable to check, returns false if blocked)
+bool TowerRobot::verifyGrasp(int tower, int blockNum, bool* held) {
+  *held = true;
+
+  //Sensor reads tower from previous tower's position
+  int prevTower = turret->nextTower(tower, -1);
+
+  //Cargo can only swing over previous tower if it is below vacated level
+  if ((!colorInit) || (!graspCheck) || (towerHeights[prevTower] > blockNum)) {
+    return true;
+  }
+
+  //Lifts cargo off tower, then aligns sensor with vacated level
+  slide->moveToClear(blockNum);
+  turret->moveToTower(prevTower);
+
+  //Yields for previous tower before cargo swings over it, as on any approach
+  if (irtInit) {
+    sendYield();
+
+    sleep(irt->getCycle());
+
+    if (!updateYield()) {
+      return false;
+    }
+  }
+
+  if (!waitSlideTurret()) {
+    return false;
+  }
+
+  *held = (senseColor() == EMPTY);
+  return true;
+}
+
+//Updates tower height and model with scanned color
+void TowerRobot::recordColor(int tower, int blockNum, int color) {
+  //Updates tower height
+  if ((color > EMPTY) && (blockNum >= towerHeights[tower])) {
+    towerHeights[tower] = blockNum + 1;
+  } else if ((color == EMPTY) && (blockNum < towerHeights[tower])) {
+    towerHeights[tower] = blockNum;
+  }
+
+  //Updates tower model
+  if (color == EMPTY) {
+    model.clear(tower, blockNum);
+  } else {
+    model.setColor(tower, blockNum, color);
+  }
+}
+
+//Sets whether colors are read opportunistically during moves
+void TowerRobot::setTransitSampling(bool active) {
+  transitSampling = active;
+}
+
+//Sets whether grasps are checked with color sensor after loading
+void TowerRobot::setGraspCheck(bool active) {
+  graspCheck = active;
+}
+
+//Reads unknown blocks the color sensor passes during normal moves
+void TowerRobot::sampleTransit() {
+  if ((!colorInit) || (!transitSampling)) {
+    return;
+  }
+
+  //Samples at most once per ms, as step loops call this far more often
+  if (millis() == transitTime) {
+    return;
+  }
+  transitTime = millis();
+
+  double slidePos = slide->currentPosition();
+  double turretPos = turret->currentPosition();
+
+  if (transitActive) {
+    if (colorSensor->poll()) {
+      transitActive = false;
+
+      //Only keeps read if sensor stayed on the same block throughout
+      if ((binLevel(transitSlide, slidePos) == transitLevel) && (binTower(transitTurret, turretPos) == transitTower)) {
+        recordColor(transitTower, transitLevel, colorSensor->result());
+      }
+    }
+  } else {
+    //Gets block sensor is aligned with
+    int level = binLevel(slidePos, slidePos);
+    int tower = binTower(turretPos, turretPos);
+
+    //Starts read if block color is unknown, only in own color channel so LED stays out of other robots' reads
+    bool channel = (!irtInit) || irt->onChannel(2, COLOR_CYCLE);
+    if (channel && (level >= 0) && (level < MAX_LEVELS) && (tower >= 0) && (getColor(tower, level) == UNSCANNED)) {
+      transitTower = tower;
+      transitLevel = level;
+      transitSlide = slidePos;
+      transitTurret = turretPos;
+
+      colorSensor->startRead();
+      transitActive = true;
+    }
+  }
+}
+
+//Gets most common color from votes (empty, black, white, red, blue)
+int TowerRobot::topVote(uint8_t* votes) {
+  int best = -1;
+  for (int res = 0; res < 5; res++) {
+    if ((votes[res] > 0) && ((best < 0) || (votes[res] > votes[best]))) {
+      best = res;
+    }
+  }
+
+  //No reads counted
+  if (best < 0) {
+    return UNSCANNED;
+  }
+  return best + EMPTY;
+}
+
+//Gets block level read over a slide movement, or -1 if it spans more than one level
+int TowerRobot::binLevel(double startPos, double endPos) {
+  //Level aligned with sensor at middle of read
+  int level = round((startPos + endPos)/2 - sensorMargin);
+
+  //Both ends of read must be within bin
+  if ((abs(startPos - sensorMargin - level) > binMargin) || (abs(endPos - sensorMargin - level) > binMargin)) {
+    return -1;
+  }
+  return level;
+}
+
+//Gets tower read over a turret movement, or -1 if sensor was not aligned with one tower
+int TowerRobot::binTower(double startAngle, double endAngle) {
+  for (int pos = 0; pos < 4; pos++) {
+    //Angles from turret position where sensor is aligned with next tower
+    double startDist = Utils::modulo(startAngle - turret->getTowerPos(pos) + 180, 360.0) - 180;
+    double endDist = Utils::modulo(endAngle - turret->getTowerPos(pos) + 180, 360.0) - 180;
+
+    if ((abs(startDist) <= alignMargin) && (abs(endDist) <= alignMargin)) {
+      //Sensor reads tower clockwise from turret position
+      return turret->nextTower(pos, 1);
+    }
+  }
+  return -1;
+}
+
+//Scans one level of every tower in a single turret revolution
+bool TowerRobot::scanRow(int blockNum, int* colors) {
+  for (int i = 0; i < 4; i++) {
+    colors[i] = UNSCANNED;
+  }
+
+  //Open gripper can only pass towers without cargo
+  if ((!colorInit) || (cargo > 0)) {
+    return false;
+  }
+
+  //Moves to level at closest tower position
+  setTurretTarget(-1);
+  while (!moveToBlock(turret->closestTower(), blockNum + sensorMargin)) {
+
+  }
+
+  //Votes for each result at each tower (empty, black, white, red, blue)
+  uint8_t votes[4][5];
+  memset(votes, 0, sizeof(votes));
+
+  //Sweeps through remaining tower positions while reading
+  journalMove();
+  turret->moveBy(270, turret->getDefaultAccel(), rowSpeed);
+  //Takes sensor over from any transit read
+  transitActive = false;
+  colorSensor->startRead();
+  double readStart = turret->currentPosition();
+  while (true) {
+    //Yields to other robots as turret passes towers
+    if (!updateYield()) {
+      return false;
+    }
+    bool turretRun = turret->run();
+
+    if (colorSensor->poll()) {
+      //Tags read with tower passed during integration
+      int tower = binTower(readStart, turret->currentPosition());
+      if (tower >= 0) {
+        votes[tower][colorSensor->result() + 1]++;
+      }
+
+      //Stops after final read at end of sweep
+      if (!turretRun) {
+        break;
+      }
+
+      colorSensor->startRead();
+      readStart = turret->currentPosition();
+    }
+  }
+
+  //Records most common result at each tower
+  for (int tower = 0; tower < 4; tower++) {
+    colors[tower] = topVote(votes[tower]);
+    if (colors[tower] != UNSCANNED) {
+      recordColor(tower, blockNum, colors[tower]);
+    }
+  }
+
+  return true;
+}
+
+//Scans range of blocks in one continuous slide sweep (returns tower height, -1 if blocked)
+int TowerRobot::scanColumn(int tower, int fromBlock, int toBlock) {
+  if (colorInit) {
+    //Gets sweep direction and number of levels
+    int dir = (toBlock >= fromBlock) ? 1 : -1;
+    int numLevels = abs(toBlock - fromBlock) + 1;
+    if (numLevels > MAX_LEVELS) {
+      numLevels = MAX_LEVELS;
+      toBlock = fromBlock + dir*(numLevels - 1);
+    }
+
+    //Opens gripper to clear towers
+    gripper->open();
+
+    //Moves to start of sweep with color sensor aligned to tower
+    setTurretTarget(-1);
+    while (!moveToBlock(turret->nextTower(tower, -1), fromBlock + sensorMargin)) {
+      
+    }
+
+    if (irtInit) {
+      irt->waitChannel(2, COLOR_CYCLE);
+    }
+
+    //Votes for each result at each level (empty, black, white, red, blue)
+    uint8_t votes[MAX_LEVELS][5];
+    memset(votes, 0, sizeof(votes));
+
+    //Sweeps slowly past tower while reading
+    journalMove();
+    slide->moveToBlock(toBlock + sensorMargin, slide->getDefaultAccel(), scanSpeed);
+    //Takes sensor over from any transit read
+    transitActive = false;
+    colorSensor->startRead();
+    double readStart = slide->currentPosition();
+    while (true) {
+      //Yields to other robots during sweep
+      if (!updateYield()) {
+        return -1;
+      }
+      bool slideRun = slide->run();
+
+      if (colorSensor->poll()) {
+        //Tags read with level passed during integration
+        int level = binLevel(readStart, slide->currentPosition());
+        int index = (level - fromBlock)*dir;
+        if ((level >= 0) && (index >= 0) && (index < numLevels)) {
+          votes[index][colorSensor->result() + 1]++;
+        }
+
+        //Stops after final read at end of sweep
+        if (!slideRun) {
+          break;
+        }
+
+        colorSensor->startRead();
+        readStart = slide->currentPosition();
+      }
+    }
+
+    //Records levels from top down so lowest empty level sets height
+    for (int i = numLevels - 1; i >= 0; i--) {
+      int index = (dir > 0) ? i : (numLevels - 1 - i);
+
+      //Uses most common result at level
+      int color = topVote(votes[index]);
+      if (color != UNSCANNED) {
+        recordColor(tower, fromBlock + index*dir, color);
+      }
+    }
+  }
+
+  return towerHeights[tower];
+}
+
 //Synchronizes so all robots start at the same time
 void TowerRobot::synchronize() {
   if (irtInit) {
@@ -386,7 +1040,9 @@ void TowerRobot::synchronize() {
       //Waits until done is received
       irt->waitReceive();
       irt->receive(&command, &data);
-      irt->resume();
+
+      //Allows tuning before start
+      updateParams(command, data);
 
       if (command == DONE) {
         //Starts synchronization
@@ -406,7 +1062,7 @@ void TowerRobot::synchronize() {
   }
 }
 
-//Sets whether undirected commands are automatically relayed
+//Sets whether frames for other robots are relayed
 void TowerRobot::setAutoRelay(bool active) {
   irt->setAutoRelay(active);
 }
@@ -444,38 +1100,38 @@ void TowerRobot::sendYield() {
     //Target indicator
     unsigned int toTarget = (int) (nextTower == turretTarget);
 
+    //Time to reach next tower at full speed (tenths of a second)
+    double angle = abs(Utils::modulo(turret->getTowerPos(nextTower) - turret->currentPosition() + 180, 360.0) - 180);
+    unsigned int eta = min(round(angle/turret->getDefaultMax()*10), (double) Yield::Eta::limit());
+
+    //Next tower, target indicator, clear height (top of cargo) and arrival time
+    unsigned int data = Yield::Tower::encode(nextTower) | Yield::ToTarget::encode(toTarget) | Yield::Height::encode(slide->targetBlock() + cargo) | Yield::Eta::encode(eta);
+
     //Chooses loading or unloading command
+    bool queued;
     if (cargo == 0) {
-      //Sends load data with target indicator and next tower
-      irt->send(MASTER_ADDRESS, LOAD, toTarget*4 + nextTower);
+      queued = irt->send(MASTER_ADDRESS, LOAD, data);
+    } else if (toTarget) {
+      queued = irt->send(MASTER_ADDRESS, UNLOAD_TARGET, data);
     } else {
-      //Unload data with clear height and next tower
-      unsigned int data = (slide->targetBlock() + cargo)*4 + nextTower;
-
-      //Sets command based on target indicator
-      unsigned int command;
-      if (toTarget) {
-        command = UNLOAD_TARGET;
-      } else {
-        command = UNLOAD_TRAVEL;
-      }
-
-      //Sends data
-      irt->send(MASTER_ADDRESS, command, data);
+      queued = irt->send(MASTER_ADDRESS, UNLOAD_TRAVEL, data);
     }
     
-    //Waits until sent unless something is received
-    irt->setInterrupt();
-    irt->waitSend();
+    //Drops signal if something is received before it is sent
+    if (queued) {
+      irt->setInterrupt();
+    }
   }
 }
 
 //Sends done signal to previous tower
 void TowerRobot::sendDone() {
+  sendDone(turret->targetTower());
+}
+//Sends done signal to tower
+void TowerRobot::sendDone(int tower) {
   if (irtInit && (yieldMode == PENDING)) {
-    //Sends done at previous tower
-    irt->send(MASTER_ADDRESS, DONE, turret->targetTower());
-    irt->waitSend();
+    irt->send(MASTER_ADDRESS, DONE, Yield::Tower::encode(tower), PRIORITY_HIGH);
   }
 }
 
@@ -511,7 +1167,10 @@ bool TowerRobot::updateYield() {
       //Updates signals
       irt->update();
       if (irt->receive(&command, &data)) {
-        irt->resume();
+        //Parameter updates are not yield messages
+        if (updateParams(command, data)) {
+          continue;
+        }
 
         //Gets next tower
         int nextTower = turret->nextTower();
@@ -519,8 +1178,17 @@ bool TowerRobot::updateYield() {
         //Whether robot is heading to target
         bool toTarget = (nextTower == turretTarget);
 
+        //Tower and clear height of other robot
+        int otherTower = Yield::Tower::decode(data);
+        int otherHeight = Yield::Height::decode(data);
+
+        //Forgets towers changed by other robots
+        if (command == DONE) {
+          model.forget(otherTower);
+        }
+
         //If next tower matches
-        if (data % 4 == nextTower) {
+        if (otherTower == nextTower) {
           if (command == DONE) {
             //Unblocks if done sent at tower
             yieldMode = PENDING;
@@ -536,7 +1204,7 @@ bool TowerRobot::updateYield() {
               otherLoading = true;
 
               //Gets target state based on indicator
-              otherToTarget = (data / 4);
+              otherToTarget = Yield::ToTarget::decode(data);
             } else {
               otherLoading = false;
 
@@ -546,7 +1214,7 @@ bool TowerRobot::updateYield() {
 
             if ((cargo > 0) && !otherLoading) {
               //If both robots are unloading, checks for higher robot
-              if (slide->targetBlock() + cargo >= data / 4) {
+              if (slide->targetBlock() + cargo >= otherHeight) {
                 //Blocks if targets match
                 if (toTarget && otherToTarget) {
                   yieldMode = BLOCKED;
@@ -554,11 +1222,12 @@ bool TowerRobot::updateYield() {
                 }
 
                 //Moves to clear other robot
-                if (slide->targetBlock() <= data / 4) {
-                  int clearHeight = getStaggerPos(data / 4);
-                  while(clearHeight < data / 4) {
+                if (slide->targetBlock() <= otherHeight) {
+                  int clearHeight = getStaggerPos(otherHeight);
+                  while(clearHeight < otherHeight) {
                     clearHeight += irt->getChannels();
                   }
+                  journalMove();
                   slide->moveToClear(clearHeight);
                   slide->wait();
                 }
@@ -577,6 +1246,7 @@ bool TowerRobot::updateYield() {
 
                 //If loading and other is unloading, move to carry position to avoid interference
                 if ((cargo == 0) && !otherLoading) {
+                  journalMove();
                   turret->moveToCarry(turret->nextTower());
                   turret->wait();
                 }
@@ -603,7 +1273,11 @@ void TowerRobot::remoteControl() {
     irt->update();
     unsigned int command, data;
     if (irt->receive(&command, &data)) {
-      irt->resume();
+      updateParams(command, data);
+
+      if ((command == SLIDE) || (command == TURRET) || (command == CARRY)) {
+        journalMove();
+      }
 
       if (command == SLIDE) {
         slide->moveToBlock(data);
@@ -622,67 +1296,132 @@ void TowerRobot::remoteControl() {
   }
 }
 
-//Finds height of tower
-int TowerRobot::findHeight(int tower) {
-  return findHeight(tower, new int[10]);
+//Gets known color of block without scanning
+int TowerRobot::getColor(int tower, int blockNum) {
+  if (model.heightKnown(tower) && (blockNum >= towerHeights[tower])) {
+    return EMPTY;
+  }
+  return model.getColor(tower, blockNum);
 }
-int TowerRobot::findHeight(int tower, int* bufferColors) {
-  //Gets predicted tower height
-  int currHeight = towerHeights[tower];
-  int currBlock = currHeight;
 
-  //Resets buffer color array
-  for (int i = 0; i < 10; i++) {
-    *(bufferColors + i) = -2;
+//Gets color of block from model or scans it if unknown
+int TowerRobot::readColor(int tower, int blockNum) {
+  int color = getColor(tower, blockNum);
+  if (color == UNSCANNED) {
+    color = scanBlock(tower, blockNum);
+  }
+  return color;
+}
+
+//Whether a block is at level, using known colors before scanning
+bool TowerRobot::occupied(int tower, int blockNum) {
+  return readColor(tower, blockNum) != EMPTY;
+}
+
+//Finds height of tower by galloping from predicted height then bisecting
+int TowerRobot::findHeight(int tower) {
+  //Height is at most one above highest level the sensor can reach
+  int high = floor(slide->getUpperLimit() - sensorMargin) + 1;
+  if (high > MAX_LEVELS) {
+    high = MAX_LEVELS;
   }
-  
-  //Finds actual tower height
-  bool startedEmpty = false;
-  while (currBlock >= 0) {
-    int checkColor = scanBlock(tower, currBlock);
 
-    //Checks whether the first check was empty
-    if (currBlock == currHeight) {
-      startedEmpty = (checkColor == EMPTY);
+  //Checks confirmed height with one scan above it, as a missed yield would leave it stale
+  if (model.heightKnown(tower)) {
+    if ((towerHeights[tower] >= high) || (scanBlock(tower, towerHeights[tower]) == EMPTY)) {
+      return towerHeights[tower];
     }
+    model.setHeightKnown(tower, false);
+  }
 
-    //Updates buffer array with color
-    if (checkColor != EMPTY) {
-      *(bufferColors + currBlock) = checkColor;
-    }    
-    
-    if (startedEmpty) {
-      //Moves down until tower is found
-      if (checkColor != EMPTY) {
+  //Height is at least one above highest known block
+  int low = 0;
+  for (int i = 0; i < MAX_LEVELS; i++) {
+    if (model.isKnown(tower, i)) {
+      low = i + 1;
+    }
+  }
+  if (low > high) {
+    low = high;
+  }
+
+  //Starts from predicted tower height
+  int pred = constrain(towerHeights[tower], low, high);
+
+  if ((pred < high) && occupied(tower, pred)) {
+    //Gallops up with doubling steps until a level is empty
+    low = pred + 1;
+    int step = 1;
+    while (low < high) {
+      int probe = min(pred + step, high - 1);
+      if (occupied(tower, probe)) {
+        low = probe + 1;
+      } else {
+        high = probe;
         break;
       }
-      currBlock--;
-    } else {
-      //Moves up until no tower is found
-      if (checkColor == EMPTY) {
+      step *= 2;
+    }
+  } else {
+    //Gallops down with doubling steps until a level has a block
+    high = pred;
+    int step = 1;
+    while (low < high) {
+      int probe = max(pred - step, low);
+      if (occupied(tower, probe)) {
+        low = probe + 1;
         break;
+      } else {
+        high = probe;
       }
-      currBlock++;
+      step *= 2;
     }
   }
 
-  //Returns height
-  return towerHeights[tower];
+  //Bisects remaining range
+  while (low < high) {
+    int mid = (low + high)/2;
+    if (occupied(tower, mid)) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+
+  //Height is confirmed until another robot changes it
+  towerHeights[tower] = low;
+  model.clear(tower, low);
+  model.setHeightKnown(tower, true);
+
+  return low;
 }
 
 
 //Scans tower for target blocks
-int TowerRobot::scanTower(int tower, int color, bool* startedTarget, int* bufferColors) {
-  //Loops through checked colors and then finds more colors if necessary
+int TowerRobot::scanTower(int tower, int color, bool* startedTarget) {
+  //Finds unknown levels
+  int lowUnknown = -1;
+  int highUnknown = -1;
+  for (int i = 0; i < towerHeights[tower]; i++) {
+    if (getColor(tower, i) == UNSCANNED) {
+      if (lowUnknown < 0) {
+        lowUnknown = i;
+      }
+      highUnknown = i;
+    }
+  }
+
+  //Sweeps down tower once if more than one level is unknown
+  if (highUnknown > lowUnknown) {
+    scanColumn(tower, highUnknown, lowUnknown);
+  }
+
+  //Loops through known colors and then scans more colors if necessary
   int currBlock;
   for (currBlock = towerHeights[tower]; currBlock > 0;) {
     currBlock--;
 
-    //If color is not read, reads it in
-    int checkColor = *(bufferColors + currBlock);
-    if (checkColor == -2) {
-      checkColor = scanBlock(tower, currBlock);
-    }
+    int checkColor = readColor(tower, currBlock);
 
     //Checks whether the top of the tower was the target color
     if (currBlock == (towerHeights[tower] - 1)) {
@@ -699,4 +1438,42 @@ int TowerRobot::scanTower(int tower, int color, bool* startedTarget, int* buffer
 
   //Returns wether tower started with target blocks
   return currBlock;
-}
\ No newline at end of file
+}
+
+//Prints size of one memory report entry
+static void printMemoryLine(Print* out, const __FlashStringHelper* name, int bytes) {
+  out->print(name);
+  out->print(F(": "));
+  out->println(bytes);
+}
+
+//Prints RAM used by each subsystem and overall memory state
+void TowerRobot::printMemory(Print* out) {
+  //Static size of each subsystem object
+  printMemoryLine(out, F("TowerRobot"), sizeof(TowerRobot));
+  printMemoryLine(out, F("TowerModel"), sizeof(TowerModel));
+  printMemoryLine(out, F("Slide"), sizeof(Slide));
+  printMemoryLine(out, F("Turret"), sizeof(Turret));
+  printMemoryLine(out, F("ScaledStepper (each)"), sizeof(ScaledStepper));
+  printMemoryLine(out, F("Button"), sizeof(Button));
+  printMemoryLine(out, F("Gripper"), sizeof(Gripper));
+  if (colorInit) {
+    printMemoryLine(out, F("ColorSensor"), sizeof(ColorSensor));
+  }
+  if (irtInit) {
+    printMemoryLine(out, F("IRT"), sizeof(IRT));
+  }
+
+  //Overall RAM state
+  printMemoryLine(out, F("Static RAM"), Memory::staticRam());
+  printMemoryLine(out, F("Free heap"), Memory::freeHeap());
+  printMemoryLine(out, F("Stack used"), Memory::stackUsed());
+  printMemoryLine(out, F("Stack unused"), Memory::stackUnused());
+}
+
+//Prints memory report when requested over serial
+void TowerRobot::updateMemory(Stream* serial) {
+  if ((serial->available() > 0) && (serial->read() == MEMORY_REQUEST)) {
+    printMemory(serial);
+  }
+}
@@ -8,11 +8,14 @@
 
 #include <Arduino.h>
 #include <Servo.h>
-#include <Wire.h>
-#include <Adafruit_TCS34725.h>
 #include "ScaledStepper.h"
 #include "Utils.h"
 #include "Button.h"
+#include "Memory.h"
+#include "AsyncTWI.h"
+#include "Message.h"
+#include "IRLine.h"
+#include "IRTransmitter.h"
 
 //Commands
 
@@ -22,6 +25,60 @@ namespace BlockColors {
 	#define WHITE 1
 	#define RED 2
 	#define BLUE 3
+
+	//Color not yet scanned
+	#define UNSCANNED -2
+
+	//Levels tracked per tower
+	#define MAX_LEVELS 16
+
+	//Model column holding cargo
+	#define CARGO_COLUMN 4
+}
+
+namespace ReadStates {
+	//No read in progress
+	#define READ_IDLE 0
+
+	//Integrating with LED off
+	#define READ_AMBIENT 1
+
+	//Integrating with LED on
+	#define READ_REFLECTED 2
+
+	//Result availiable
+	#define READ_DONE 3
+}
+
+namespace ColorRegisters {
+	//TCS34725 bus address and bus speed
+	#define TCS_ADDRESS 0x29
+	#define TCS_CLOCK 400000
+
+	//Command byte for single register and auto-increment access
+	#define TCS_COMMAND 0x80
+	#define TCS_AUTO_INC 0xA0
+
+	//Registers
+	#define TCS_ENABLE 0x00
+	#define TCS_ATIME 0x01
+	#define TCS_CONTROL 0x0F
+	#define TCS_ID 0x12
+	#define TCS_STATUS 0x13
+
+	//Enable bits (interrupt enable turns LED off)
+	#define TCS_PON 0x01
+	#define TCS_AEN 0x02
+	#define TCS_AIEN 0x10
+
+	//Status valid bit
+	#define TCS_AVALID 0x01
+
+	//Bytes from status through blue data (status, c, r, g, b)
+	#define TCS_BLOCK 9
+
+	//Longest wait for sensor to answer at start (ms)
+	#define TCS_BEGIN_TIMEOUT 50
 }
 
 namespace IRcommands {
@@ -31,6 +88,61 @@ namespace IRcommands {
 	//Color sensor channel size
 	#define COLOR_CYCLE 300
 
+	//Received frames held until read
+	#define IR_QUEUE 8
+
+	//Frames waiting to be sent
+	#define IR_SEND_QUEUE 4
+
+	//Airtime of one NEC frame (ms)
+	#define IR_FRAME_TIME 68
+
+	//Line protocols
+	#define IR_PROTOCOL_NEC 0
+	#define IR_PROTOCOL_LINE 1
+
+	//Addresses tracked for sequence numbers and link quality
+	#define IR_PEERS 16
+
+	//Link quality of unmeasured peers (out of 255)
+	#define IR_QUALITY_START 192
+
+	//Weight of newest sample in link quality average (1/2^n)
+	#define IR_QUALITY_SHIFT 2
+
+	//Chance a burst of adaptive repeats is lost that is accepted (out of 256)
+	#define IR_MISS_TARGET 13
+
+	//Most sends of a frame with adaptive repeats
+	#define IR_MAX_REPEATS 4
+
+	//Gap after each frame in dynamic time slots (ms)
+	#define IR_SLOT_GUARD 12
+
+	//Time without frames before a robot's dynamic slot is released (ms)
+	#define IR_SLOT_IDLE 20000
+
+	//Time without frames before a source's sequence number stops marking repeats, as it may have restarted (ms)
+	#define IR_SEQUENCE_EXPIRE 5000
+
+	//Robots without a slot try the join slot at least once in this many rounds
+	#define IR_JOIN_BACKOFF 2
+
+	//Time between clock beacons from reference robot (ms)
+	#define IR_BEACON_INTERVAL 1000
+
+	//Missed beacons before reference robot is given up
+	#define IR_BEACON_MISSES 4
+
+	//Share of clock error corrected right away and added to drift per beacon
+	#define IR_CLOCK_PHASE_GAIN 0.25
+	#define IR_CLOCK_DRIFT_GAIN 0.01
+
+	//Send priorities
+	#define PRIORITY_LOW 0
+	#define PRIORITY_NORMAL 1
+	#define PRIORITY_HIGH 2
+
 	//Address accepted by all
 	#define MASTER_ADDRESS 0x0
 
@@ -45,6 +157,15 @@ namespace IRcommands {
 	#define UNLOAD_TRAVEL 0x2
 	#define UNLOAD_TARGET 0x3
 
+	//Parameter update (parameter, value and whether to save all)
+	#define PARAM 0x4
+
+	//Acknowledgement of an addressed frame (sequence number received)
+	#define ACK 0x5
+
+	//Network time of reference robot
+	#define BEACON 0x6
+
 	//Remote control commands
 	#define SLIDE 0xA
 	#define TURRET 0xB
@@ -52,6 +173,46 @@ namespace IRcommands {
 	#define GRIPPER 0xD                                                                                                                            
 }
 
+namespace Storage {
+	//EEPROM address of calibration record
+	#define CALIBRATION_START 0
+
+	//Layout version of calibration record
+	#define CALIBRATION_VERSION 3
+
+	//Optional components present when calibration was saved
+	#define CALIBRATION_IRT 0x1
+	#define CALIBRATION_COLOR 0x2
+
+	//EEPROM address of state journal ring
+	#define JOURNAL_START 256
+
+	//Number of state records in ring
+	#define JOURNAL_SLOTS 12
+}
+
+namespace Params {
+	//Time channel size (10 ms units)
+	#define PARAM_IR_CYCLE 0
+
+	//Yield send angle (degrees)
+	#define PARAM_SEND_ANGLE 1
+
+	//Number of staggering channels
+	#define PARAM_STAGGER_NUM 2
+
+	//Slide default acceleration and max speed (0.1 block units)
+	#define PARAM_SLIDE_ACCEL 3
+	#define PARAM_SLIDE_MAX 4
+
+	//Turret default acceleration and max speed (degree units)
+	#define PARAM_TURRET_ACCEL 5
+	#define PARAM_TURRET_MAX 6
+
+	//No parameter (only saves)
+	#define PARAM_NONE 15
+}
+
 namespace YieldModes {
 	#define DORMANT 0
 	#define PENDING 1
@@ -89,14 +250,28 @@ class TowerRobot {
 				//Margin to clear blocks after loading
 				double clearMargin = 0.3;
 
+				//Allowed error when verifying remembered position
+				double verifyMargin = 0.25;
+
 				//Current block position
 				int targetBlockPos = 0;
 
 				double convertToBlock(double raw);
 				double convertToRaw(double block);
+
+				void seekLimit();
 			public:
 				Slide(double stepsPerBlock, double upperLimit, ScaledStepper* stepper, Button* limit);
 
+				double getStepsPerBlock();
+				void setStepsPerBlock(double stepsPerBlock);
+
+				double getDefaultAccel();
+				void setDefaultAccel(double accel);
+
+				double getDefaultMax();
+				void setDefaultMax(double max);
+
 				double distanceToGo();
 				void wait();
 
@@ -113,7 +288,11 @@ class TowerRobot {
 				void home();
 				void home(double homePos);
 
+				void setCurrentPosition(double blockPos);
+				bool verify();
+
 				double getHomePos();
+				double getUpperLimit();
 				int targetBlock();
 				double getClearMargin();
 				double getStepError();
@@ -162,12 +341,27 @@ class TowerRobot {
 			public:
 				Turret(double stepsPerDegree, ScaledStepper* stepper);
 
+				double getStepsPerDegree();
+				void setStepsPerDegree(double stepsPerDegree);
+
+				double getDefaultAccel();
+				void setDefaultAccel(double accel);
+
+				double getDefaultMax();
+				void setDefaultMax(double max);
+
+				void setTowerPos(int tower, double degree);
+
+				double getCarryOffset();
+				void setCarryOffset(double carryOffset);
+
 				double localDistance(double targetPos);
 
 				double distanceToGo();
 				void wait();
 
 				void home();
+				void home(double degree);
 
 				double currentPosition();
 				double currentPosition(bool global);
@@ -230,6 +424,9 @@ class TowerRobot {
 
 				void begin();
 
+				int getGripPos(bool openState);
+				void setGripPos(bool openState, int pos);
+
 				void open();
 				void close();
 
@@ -244,8 +441,17 @@ class TowerRobot {
 
 		class ColorSensor {
 			private:
-				//Color sensor object
-				Adafruit_TCS34725 tcs;
+				//Cached enable register
+				uint8_t enable = TCS_PON | TCS_AIEN;
+
+				//Status and channel data of last burst read (filled by TWI interrupt)
+				volatile uint8_t data[TCS_BLOCK];
+
+				//Status of burst read
+				volatile uint8_t burst = TWI_IDLE;
+
+				//Whether burst read on the bus was queued before last restart
+				bool stale = false;
 
 				//Empty/block present threshold
 				int emptyThres = 120;
@@ -258,10 +464,115 @@ class TowerRobot {
 					{54, 184, 390}
 				};
 
+				//Current read state
+				int readState = READ_IDLE;
+
+				//Start time of current integration
+				unsigned long readStart = 0;
+
+				//Time to give up waiting for valid data
+				unsigned long readTimeout = 250;
+
+				//Ambient and reflected channel values (r, g, b, c)
+				int ambient[4];
+				int reflected[4];
+
+				//Whether ambient estimate is reused between reads
+				bool ambientModel = true;
+
+				//Whether ambient estimate is availiable
+				bool ambientValid = false;
+
+				//Time of last ambient measurement
+				unsigned long ambientTime = 0;
+
+				//Time between scheduled ambient measurements
+				unsigned long ambientPeriod = 5000;
+
+				//Clear channel drift on an empty read that forces a new ambient measurement
+				int driftThres = 30;
+
+				//Integration cycles (2.4 ms each) and gain index color values are calibrated at (50 ms, 4x)
+				uint8_t refCycles = 21;
+				int refGain = 1;
+
+				//Integration cycles and gain index currently set
+				uint8_t cycles = 21;
+				int gainIndex = 1;
+
+				//Integration cycles of each step of an adaptive read (24 ms, 50 ms, 101 ms)
+				uint8_t stepCycles[3] = {10, 21, 42};
+
+				//Current step of reflected read
+				int readStep = 0;
+
+				//Whether reflected reads stop once confident
+				bool adaptive = true;
+
+				//Confidence (percent) that ends a reflected read early
+				int minConfidence = 40;
+
+				//Confidence (percent) of last result
+				int confidence = 0;
+
+				//Reflected values summed over steps, weighted by integration cycles
+				long accum[4];
+				int accumCycles = 0;
+
 				int numColors();
+
+				bool readRegs(uint8_t reg, volatile uint8_t* values, int length, volatile uint8_t* status);
+				bool writeRegs(uint8_t reg, uint8_t* values, int length);
+
+				void setLed(bool led);
+				void setIntegration(uint8_t cycles, int gainIndex);
+				void restart(bool led);
+				void dropBurst();
+				bool dataValid();
+				void readChannels(int* channels);
+				void normalize(int* channels);
+				bool saturated(int* channels);
+
+				void startReflected();
+				void nextStep(int* channels);
+
+				//Chromaticity (red and green share out of 256) of each color
+				int chroma[4][2];
+
+				//Intensity (r + g + b) splitting black from white
+				long neutralThres = 0;
+
+				void updateCentroids();
+				long chromaDiff(int color, int red, int green);
+
+				int classify(int* channels);
+				int classify(int* channels, int* confidence);
 			public:
 				ColorSensor();
 				bool begin();
+
+				bool calibrate(int color, int samples);
+
+				int getEmptyThres();
+				void setEmptyThres(int emptyThres);
+
+				void getColorValues(int color, int* r, int* g, int* b);
+				void setColorValues(int color, int r, int g, int b);
+
+				void setAdaptive(bool active);
+				void setMinConfidence(int minConfidence);
+				int getConfidence();
+
+				void setAmbientModel(bool active);
+				void setAmbientPeriod(unsigned long period);
+				void refreshAmbient();
+
+				void startRead();
+				bool poll();
+				bool isReading();
+				void result(int* r, int* g, int* b, int* c);
+				int result();
+
 				void getRaw(bool led, int* r, int*g, int*b, int* c);
 				void getReflected(int* r, int*g, int*b, int* c);
 				int getBlockColor();
@@ -276,84 +587,215 @@ class TowerRobot {
 				int recvPin;
 
 				//Unique address
-				int address;
-
-				//Address bitmap (address, command)
-				int bitMap[2] = {4, 4};
+				unsigned int address;
 
 				//Whether sending is active
 				bool sendActive = true;
 
-				//Current sending address
-				unsigned int sendAddress = 0;
-				
-				//Current sending command
-				unsigned int sendCommand = 0;
+				//Frame waiting to be sent
+				struct Outgoing {
+					//Whole frame (header and payload)
+					uint32_t frame;
+
+					//Higher priority frames are sent first
+					uint8_t priority;
+
+					//Sends left (-1 sends until replaced or cancelled)
+					int repeats;
+
+					//Time between sends and time of last send
+					int interval;
+					unsigned long lastSend;
+
+					//Whether a received frame cancels it
+					bool interruptible;
+
+					//Resends left if not acknowledged
+					uint8_t retries;
+				};
+
+				//Frames waiting to be sent, in order queued
+				Outgoing sendQueue[IR_SEND_QUEUE];
+				int numQueued = 0;
+
+				//Index of last queued frame
+				int lastQueued = -1;
 
 				//Time of last send
 				unsigned long lastSend = 0;
 
-				//Current repeating interval
-				int currInterval = 0;
-				
-				//Interval to use
-				int setInterval = 0;
+				//Whether a frame is being sent in the background
+				bool transmitting = false;
 
-				//Current signal repeats
-				int currRepeats = 0;
+				//Interval between repeats of new frames
+				int setInterval = 0;
 
-				//Limit on number of signal repeats
-				int sendRepeats = 0;
+				//Sends of new frames
+				int sendRepeats = 1;
 
 				//Whether receiving is active
 				bool recvActive = true;
 
-				//Whether recieved signal is availiable
-				bool recvExists = false;
-
-				//Whether interrupt is in place
-				bool interrupt = false;
-
 				//Wait time to avoid receiving interference
-				int sheildTime = 15;
+				unsigned int sheildTime = 15;
 
 				//Current number of channels
 				int numChannels = 1;
 
-				//Current recieved address
-				unsigned int recvAddress = 0;
+				//Sequence number of last new frame sent
+				uint8_t sendSequence = 0;
+
+				//Whether new frames are numbered
+				bool numbered = true;
+
+				//Whether repeats follow link quality
+				bool adaptiveRepeats = false;
+
+				//Resends of unacknowledged frames
+				int ackRetries = 3;
 
-				//Current recieved command
-				unsigned int recvCommand = 0;
+				//Acknowledged frames given up on
+				unsigned int sendFailures = 0;
 
-				//Current recieved data
-				unsigned int recvData = 0;
+				//Last frame acknowledged
+				uint32_t ackedFrame = 0;
+
+				//What is known about each address
+				struct Peer {
+					//Sequence numbers lately received from address, directly or relayed
+					Message::Window seen;
+
+					//Average chance a send is acknowledged (out of 255)
+					uint8_t quality;
+
+					//Whether quality has been measured
+					bool measured;
+
+					//Whether address has ever been heard
+					bool known;
+
+					//Whether address holds a dynamic time slot
+					bool active;
+
+					//Time address was last heard (16 ms units)
+					uint16_t heard;
+
+					//Time of last frame from address, directly or relayed (16 ms units)
+					uint16_t received;
+				};
+				Peer peers[IR_PEERS];
+
+				//Received frames waiting to be read (added at head, read from tail)
+				uint32_t recvQueue[IR_QUEUE];
+				volatile uint8_t recvHead = 0;
+				volatile uint8_t recvTail = 0;
+
+				//Frames lost to a full queue
+				volatile unsigned int recvDropped = 0;
+
+				//Frames lost to receiver buffer overflow
+				unsigned int recvOverflows = 0;
 
 				//Time of synchronization start
 				unsigned long syncStart = 0;
 
 				//Whether signals for other addresses are automatically relayed
 				bool autoRelay = false;
+
+				//Relays allowed for new frames
+				int sendHops = 0;
+
+				//Time channel size
+				int cycle = IR_CYCLE;
+
+				//Whether time slots are given only to robots with traffic
+				bool dynamicSlots = false;
+
+				//Whether time channels follow network clock
+				bool clockSync = false;
+
+				//Address whose clock is followed (master address when own clock is reference)
+				unsigned int clockSource = MASTER_ADDRESS;
+
+				//Network time at last clock update (whole and fraction of ms), local time it was taken and drift since
+				unsigned long clockNetwork = 0;
+				double clockPhase = 0;
+				unsigned long clockLocal = 0;
+				double clockDrift = 0;
+
+				//Whether a beacon from clock source has set network time
+				bool clockLocked = false;
+
+				//Local time of last beacon sent or received
+				unsigned long lastBeacon = 0;
+
+				//Round when joining was last decided and whether to join in it
+				unsigned long joinRound = 0;
+				bool joining = false;
+
+				//Line protocol frames are sent and received in
+				int protocol = IR_PROTOCOL_NEC;
 				
-				void unpack(unsigned int address, unsigned int command);
+				bool push(uint32_t frame);
+				bool queue(uint32_t frame, int priority, int repeats, int interval);
+				bool queueNew(unsigned int address, unsigned int command, unsigned int data, int priority, int repeats, int interval, int hops, bool ack);
+				bool relayed(uint32_t frame);
+
+				void acknowledge(unsigned int source, unsigned int sequence);
+				bool waitAcked(uint32_t frame);
+				void linkSample(unsigned int address, bool delivered);
+				int linkRepeats(unsigned int address);
+				unsigned long ackTimeout();
+
+				void hear(unsigned int address);
+				void releaseSlots();
+				void alignSlots(uint32_t frame);
+				int slotIndex(unsigned int address);
+				unsigned long roundTime();
+
+				void readBeacon(uint32_t frame);
+				unsigned long networkTime(double* fraction);
+				unsigned long frameAirtime(uint32_t frame);
+				unsigned long channelTime();
+
+				void removeFrame(int index);
+				bool inChannel(unsigned long duration);
+
+				bool readFrame(uint32_t* frame);
+				void sendFrame(uint32_t frame);
 			public:
 				IRT(int address, int sendPin, int recvPin);
 
 				void begin();
 
 				int getAddress();
+				void setAddress(int address);
 
 				void setSendActive(bool active);
 
-				void send(unsigned int address, unsigned int command);
-				void send(unsigned int address, unsigned int command, unsigned int data);
+				bool send(unsigned int address, unsigned int command);
+				bool send(unsigned int address, unsigned int command, unsigned int data);
+				bool send(unsigned int address, unsigned int command, unsigned int data, int priority);
+				bool send(unsigned int address, unsigned int command, unsigned int data, int priority, int repeats, int interval);
+
+				bool sendAcked(unsigned int address, unsigned int command, unsigned int data);
+				bool sendAcked(unsigned int address, unsigned int command, unsigned int data, int priority);
+
+				static double paramScale(int param);
+				bool sendParam(unsigned int address, int param, double value);
+				bool sendSave(unsigned int address);
+
+				void setNumbered(bool active);
+				void setAdaptiveRepeats(bool active);
+				void setAckRetries(int retries);
+
+				int getLinkQuality(unsigned int address);
+				unsigned int getSendFailures();
 
 				void setSendInterval(int interval);
 
 				void setSendRepeats(int repeats);
-				void resetSendRepeats();
-
-				void useInterval();
+				void cancelSend();
 
 				bool isSending();
 				void waitSend();
@@ -362,9 +804,11 @@ class TowerRobot {
 
 				bool receive();
 				bool receive(unsigned int*command, unsigned int*data);
-				bool receive(unsigned int*address, unsigned int*command, unsigned int*data);
+				bool receive(unsigned int*source, unsigned int*command, unsigned int*data);
 
-				void resume();
+				unsigned int getDropped();
+				unsigned int getOverflows();
+				void resetDropped();
 
 				void setInterrupt();
 
@@ -372,18 +816,156 @@ class TowerRobot {
 				bool waitReceive(int timeout);
 
 				void setAutoRelay(bool active);
+				void setSendHops(int hops);
 
 				void update();
 
 				void synchronize();
 				
+				int getCycle();
+				void setCycle(int cycle);
+
+				int getProtocol();
+				void setProtocol(int protocol);
+				int getFrameTime();
+
+				void setClockSync(bool active);
+				unsigned long getNetworkTime();
+				double getClockDrift();
+				int getClockSource();
+
+				void setDynamicSlots(bool active);
+				int getSlotTime();
+				int getActiveSlots();
+
 				void resetChannels();
 				int getChannels();
 				void setChannels(int channels);
 				void waitChannel(int channels, int size);
+				bool onChannel(int channels, int size);
 				void syncChannel(int size);
 		};
 
+		class TowerModel {
+			private:
+				//Block colors of each tower and cargo (2 bits per level)
+				uint32_t colors[5];
+
+				//Levels with known colors (1 bit per level)
+				uint16_t known[5];
+
+				//Towers with confirmed heights (1 bit per tower)
+				uint8_t heights = 0;
+
+				int numColumns();
+				void move(int from, int fromLevel, int to, int toLevel, int count);
+			public:
+				TowerModel();
+
+				int getColor(int column, int level);
+				bool isKnown(int column, int level);
+				void setColor(int column, int level, int color);
+
+				void forget(int column);
+				void clear(int column, int level);
+
+				bool heightKnown(int tower);
+				void setHeightKnown(int tower, bool state);
+
+				void load(int tower, int level, int count);
+				void unload(int tower, int level, int count);
+		};
+
+		//Robot state saved after each load and unload
+		struct State {
+			//Increases with every saved record
+			uint16_t sequence;
+
+			int8_t cargo;
+			int8_t towerHeights[4];
+
+			//Whether motors had left saved positions (slide is rehomed rather than trusted)
+			int8_t moving;
+
+			//Slide position in blocks
+			float slidePos;
+
+			//Global turret position in degrees
+			float turretPos;
+
+			TowerModel model;
+
+			//Checksum of all bytes above
+			uint8_t checksum;
+		};
+
+		//Tuned values of one robot
+		struct Calibration {
+			//Record layout version
+			uint8_t version;
+
+			//Optional components saved (CALIBRATION_IRT, CALIBRATION_COLOR)
+			uint8_t parts;
+
+			//Infrared address
+			uint8_t address;
+
+			float stepsPerBlock;
+			float stepsPerDegree;
+
+			//Turret tower positions and carry offset in degrees
+			float towerPos[4];
+			float carryOffset;
+
+			//Gripper servo positions (open, closed)
+			int16_t gripPos[2];
+
+			//Color sensor empty threshold and block color values
+			int16_t emptyThres;
+			int16_t blockColors[4][3];
+
+			//Angle to send yield signals at
+			float sendAngle;
+
+			//Time channel size and number of staggering channels
+			uint16_t irCycle;
+			uint8_t staggerNum;
+
+			//Default slide and turret motion limits
+			float slideAccel;
+			float slideMax;
+			float turretAccel;
+			float turretMax;
+
+			//Checksum of all bytes above
+			uint8_t checksum;
+		};
+
+		class Journal {
+			private:
+				//EEPROM address of first record
+				int start;
+
+				//Number of records in ring
+				int slots;
+
+				//Next record to write
+				int nextSlot = 0;
+
+				//Sequence number of last record
+				uint16_t sequence = 0;
+
+				int slotAddress(int slot);
+				uint8_t checksum(State* state);
+			public:
+				Journal(int start, int slots);
+
+				bool read(State* state);
+				void write(State* state);
+
+				void clear();
+		};
+
 		TowerRobot(Slide* slide, Turret* turret, Gripper* gripper);
 		TowerRobot(Slide* slide, Turret* turret, Gripper* gripper, ColorSensor* colorSensor);
 		TowerRobot(Slide* slide, Turret* turret, Gripper* gripper, ColorSensor* colorSensor, IRT* irt);
@@ -400,6 +982,24 @@ class TowerRobot {
 		void home();
 		void home(double homePos);
 
+		bool resume();
+		void clearState();
+
+		void getCalibration(Calibration* calib);
+		void setCalibration(Calibration* calib);
+
+		bool loadCalibration();
+		void saveCalibration();
+
+		bool calibrateColor(int color, int samples);
+
+		double getSendAngle();
+		void setSendAngle(double sendAngle);
+
+		double getParam(int param);
+		void setParam(int param, double value);
+		bool updateParams(unsigned int command, unsigned int data);
+
 		int getStaggerPos(int blockPos);
 
 		bool moveToBlock(int tower);
@@ -416,6 +1016,11 @@ class TowerRobot {
 		void setSlideTarget(int target);
 
 		int scanBlock(int tower, int blockNum);
+		int scanColumn(int tower, int fromBlock, int toBlock);
+		bool scanRow(int blockNum, int* colors);
+
+		void setTransitSampling(bool active);
+		void setGraspCheck(bool active);
 
 		void synchronize();
 		
@@ -426,14 +1031,19 @@ class TowerRobot {
 		
 		void sendYield();
 		void sendDone();
+		void sendDone(int tower);
 
 		bool updateYield();
 
 		void remoteControl();
 
+		int getColor(int tower, int blockNum);
+
 		int findHeight(int tower);
-		int findHeight(int tower, int* bufferColors);
-		int scanTower(int tower, int color, bool* startedTarget, int* bufferColors);
+		int scanTower(int tower, int color, bool* startedTarget);
+
+		void printMemory(Print* out);
+		void updateMemory(Stream* serial);
 	private:
 		Slide* slide;
 		Turret* turret;
@@ -441,6 +1051,15 @@ class TowerRobot {
 		ColorSensor* colorSensor;
 		IRT* irt;
 
+		//Known block colors and heights
+		TowerModel model;
+
+		//Saved robot state
+		Journal journal = Journal(JOURNAL_START, JOURNAL_SLOTS);
+
+		//Whether journal already records that motors left saved positions
+		bool moveJournaled = false;
+
 		//Whether color sensor is initialized
 		bool colorInit = false;
 
@@ -468,6 +1087,47 @@ class TowerRobot {
 		//Margin for color sensor to read block
 		double sensorMargin = 0.3;
 
+		//Confidence (percent) below which a scanned block is read again
+		int rescanConfidence = 40;
+
+		//Extra reads of a low confidence block
+		int rescans = 2;
+
+		//Whether grasps are checked with color sensor after loading
+		bool graspCheck = true;
+
+		//Grip attempts after a failed grasp
+		int graspRetries = 2;
+
+		//Slide speed while sweeping past a tower (blocks per second)
+		double scanSpeed = 1;
+
+		//Furthest a read may be from a level's sensor position to count for it
+		double binMargin = 0.25;
+
+		//Turret speed while sweeping past towers (degrees per second)
+		double rowSpeed = 30;
+
+		//Furthest a read may be from a tower's sensor angle to count for it
+		double alignMargin = 4;
+
+		//Whether colors are read opportunistically during moves
+		bool transitSampling = true;
+
+		//Whether a transit read is in progress
+		bool transitActive = false;
+
+		//Block targeted by transit read
+		int transitTower = 0;
+		int transitLevel = 0;
+
+		//Slide and turret positions at start of transit read
+		double transitSlide = 0;
+		double transitTurret = 0;
+
+		//Time transit reads were last sampled
+		unsigned long transitTime = 0;
+
 		//Turret angle tracker
 		double turretAngle = 0;
 
@@ -476,6 +1136,21 @@ class TowerRobot {
 
 		//Number of staggering channels
 		int staggerNum = 2;
+
+		int senseColor();
+		bool verifyGrasp(int tower, int blockNum, bool* held);
+
+		int readColor(int tower, int blockNum);
+		bool occupied(int tower, int blockNum);
+		void recordColor(int tower, int blockNum, int color);
+		int binLevel(double startPos, double endPos);
+		int binTower(double startAngle, double endAngle);
+		int topVote(uint8_t* votes);
+		void sampleTransit();
+
+		void saveState();
+		void saveState(bool moving);
+		void journalMove();
 };
 
 #endif
\ No newline at end of file
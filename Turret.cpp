@@ -15,6 +15,39 @@ TowerRobot::Turret::Turret(double stepsPerDegree, ScaledStepper* stepper) {
   stepper->setMaxSpeed(convertToRaw(defMax));
 }
 
+//Gets steps per degree
+double TowerRobot::Turret::getStepsPerDegree() {
+  return stepsPerDegree;
+}
+
+//Sets steps per degree
+void TowerRobot::Turret::setStepsPerDegree(double stepsPerDegree) {
+  this->stepsPerDegree = stepsPerDegree;
+
+  //Keeps stepper speed limit in the new scale
+  stepper->setMaxSpeed(convertToRaw(defMax));
+}
+
+//Gets default acceleration
+double TowerRobot::Turret::getDefaultAccel() {
+  return defAccel;
+}
+
+//Sets default acceleration
+void TowerRobot::Turret::setDefaultAccel(double accel) {
+  defAccel = accel;
+}
+
+//Gets default max speed
+double TowerRobot::Turret::getDefaultMax() {
+  return defMax;
+}
+
+//Sets default max speed
+void TowerRobot::Turret::setDefaultMax(double max) {
+  defMax = max;
+}
+
 //Converts raw steps to degrees
 double TowerRobot::Turret::convertToDegree(double raw) {
   return raw/stepsPerDegree;
@@ -50,8 +83,11 @@ void TowerRobot::Turret::wait() {
 
 //Homes turret at zero position
 void TowerRobot::Turret::home() {
-  //Zeros stepper position
-  stepper->setCurrentPosition(0);
+  home(0);
+}
+//Homes turret at known position
+void TowerRobot::Turret::home(double degree) {
+  stepper->setCurrentPosition(convertToRaw(degree));
 }
 
 //Returns current block position
@@ -87,6 +123,21 @@ double TowerRobot::Turret::getTowerPos(int tower) {
   return towerPos[tower];
 }
 
+//Sets position of tower
+void TowerRobot::Turret::setTowerPos(int tower, double degree) {
+  towerPos[tower] = degree;
+}
+
+//Gets carry offset
+double TowerRobot::Turret::getCarryOffset() {
+  return carryOffset;
+}
+
+//Sets carry offset
+void TowerRobot::Turret::setCarryOffset(double carryOffset) {
+  this->carryOffset = carryOffset;
+}
+
 //Gets current tower position
 int TowerRobot::Turret::targetTower() {
   return targetTowerPos;
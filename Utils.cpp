@@ -28,4 +28,22 @@ static int Utils::modulo(int dividend, int divisor) {
 
 static double Utils::modulo(double dividend, double divisor) {
     return dividend - floor(dividend/divisor)*divisor;
+}
+
+//Gets CRC-8 checksum of bytes
+uint8_t Utils::checksum(const uint8_t* data, int length) {
+    uint8_t crc = 0;
+    for (int i = 0; i < length; i++) {
+        crc ^= data[i];
+
+        //Divides by polynomial one bit at a time
+        for (int bit = 0; bit < 8; bit++) {
+            if (crc & 0x80) {
+                crc = (crc << 1) ^ 0x07;
+            } else {
+                crc <<= 1;
+            }
+        }
+    }
+    return crc;
 }
\ No newline at end of file
@@ -13,6 +13,7 @@ class Utils {
         static int sign(double val);
         static int modulo(int dividend, int divisor);
         static double modulo(double dividend, double divisor);
+        static uint8_t checksum(const uint8_t* data, int length);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,52 @@
+#include <TowerRobot.h>
+
+//Addresses of the two boards (swap on the second board)
+#define OWN_ADDRESS (CONTROL_ADDRESS+1)
+#define PEER_ADDRESS (CONTROL_ADDRESS+2)
+
+//Whether this board sends (the other only acknowledges)
+#define SENDER true
+
+//Frames sent between reports
+#define REPORT_EVERY 20
+
+//Creates IRT instance
+TowerRobot::IRT irt = TowerRobot::IRT(OWN_ADDRESS, 3, 5);
+
+using namespace IRcommands;
+
+int sent = 0;
+unsigned int received = 0;
+
+void setup() {
+  Serial.begin(9600);
+  irt.begin();
+}
+
+void loop() {
+  if (SENDER) {
+    //Counts up in payload so receiver can spot lost frames
+    irt.sendAcked(PEER_ADDRESS, DONE, sent);
+    irt.waitSend();
+    sent++;
+
+    if (sent % REPORT_EVERY == 0) {
+      Serial.print("Sent "); Serial.print(sent);
+      Serial.print(", failed "); Serial.print(irt.getSendFailures());
+      Serial.print(", link quality "); Serial.print(irt.getLinkQuality(PEER_ADDRESS));
+      Serial.println("%");
+    }
+  } else {
+    //Acknowledgements are sent from update, duplicates are dropped before receive
+    irt.update();
+
+    unsigned int source, command, data;
+    if (irt.receive(&source, &command, &data)) {
+      if (data != received) {
+        Serial.print("Expected "); Serial.print(received);
+        Serial.print(", got "); Serial.println(data);
+      }
+      received = data + 1;
+    }
+  }
+}
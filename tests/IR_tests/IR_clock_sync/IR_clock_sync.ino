@@ -0,0 +1,34 @@
+#include <TowerRobot.h>
+
+//Address of this board (lowest address on air becomes clock reference)
+#define OWN_ADDRESS (CONTROL_ADDRESS+1)
+
+//Time between reports (ms)
+#define REPORT_TIME 5000
+
+//Creates IRT instance
+TowerRobot::IRT irt = TowerRobot::IRT(OWN_ADDRESS, 3, 5);
+
+unsigned long lastReport = 0;
+
+void setup() {
+  Serial.begin(9600);
+  irt.begin();
+  irt.setClockSync(true);
+}
+
+void loop() {
+  //Beacons are sent and read in update
+  irt.update();
+
+  if (millis() - lastReport >= REPORT_TIME) {
+    lastReport = millis();
+
+    //Boards following the same reference should print matching network times (wrapping every 16384 ms)
+    Serial.print("Source "); Serial.print(irt.getClockSource());
+    Serial.print(", network time "); Serial.print(irt.getNetworkTime());
+    Serial.print(" ms, own time "); Serial.print(millis());
+    Serial.print(" ms, drift "); Serial.print(irt.getClockDrift());
+    Serial.println(" ppm");
+  }
+}
@@ -0,0 +1,82 @@
+#include <IRLine.h>
+
+//Frames per trial
+#define TRIALS 1000
+
+//Most a receiver stretches marks and shortens spaces (us)
+#define JITTER 150
+
+//Receiver tick size (us)
+#define TICK 50
+
+//Adds receiver distortion to durations and rounds down to ticks
+void distort(uint16_t* durations, uint8_t length) {
+  for (int i = 0; i < length; i++) {
+    long duration = durations[i];
+    if (i % 2 == 0) {
+      duration += random(JITTER + 1);
+    } else {
+      duration -= random(JITTER + 1);
+    }
+    durations[i] = duration / TICK * TICK;
+  }
+}
+
+void setup() {
+  Serial.begin(9600);
+  randomSeed(analogRead(0));
+
+  int correct = 0;
+  int wrong = 0;
+  int rejected = 0;
+  unsigned long airtime = 0;
+
+  //Decodes distorted frames
+  for (int i = 0; i < TRIALS; i++) {
+    uint32_t frame = ((uint32_t) random(0x10000) << 16) | random(0x10000);
+
+    uint16_t durations[IR_LINE_LENGTH];
+    uint8_t length = IRLine::encode(frame, durations);
+    airtime += IRLine::airtime(frame);
+    distort(durations, length);
+
+    uint32_t decoded;
+    if (!IRLine::decode(durations, length, &decoded)) {
+      rejected++;
+    } else if (decoded == frame) {
+      correct++;
+    } else {
+      wrong++;
+    }
+  }
+
+  Serial.print("Distorted: "); Serial.print(correct); Serial.print(" correct, ");
+  Serial.print(wrong); Serial.print(" wrong, "); Serial.print(rejected); Serial.println(" rejected");
+  Serial.print("Average airtime: "); Serial.print(airtime/TRIALS); Serial.println(" us (NEC is about 68000 us)");
+
+  //Frames missing a duration must not decode
+  int accepted = 0;
+  for (int i = 0; i < TRIALS; i++) {
+    uint32_t frame = random(0x10000);
+
+    uint16_t durations[IR_LINE_LENGTH];
+    uint8_t length = IRLine::encode(frame, durations);
+
+    //Drops one mark or space after header
+    int lost = 2 + random(length - 3);
+    for (int j = lost; j < length - 1; j++) {
+      durations[j] = durations[j + 1];
+    }
+
+    uint32_t decoded;
+    if (IRLine::decode(durations, length - 1, &decoded)) {
+      accepted++;
+    }
+  }
+
+  Serial.print("Truncated: "); Serial.print(accepted); Serial.println(" accepted");
+}
+
+void loop() {
+
+}
@@ -65,8 +65,6 @@ void loop() {
 
   int command, data;
   if (irt.receive(&command, &data)) {
-    irt->resume();
-    
     Serial.println(command);
     Serial.println(data);
   }
@@ -0,0 +1,63 @@
+#include <TowerRobot.h>
+
+//Checks which copies of numbered frames from one source are kept (no infrared hardware needed)
+
+int failures = 0;
+
+//Feeds sequence number to window and reports if it is not kept or dropped as expected
+void check(Message::Window* window, uint8_t sequence, bool expected) {
+  bool kept = window->first(sequence);
+  if (kept != expected) {
+    failures++;
+    Serial.print("Sequence "); Serial.print(sequence);
+    Serial.println(kept ? " kept, expected repeat" : " dropped, expected new");
+  }
+}
+
+void setup() {
+  Serial.begin(9600);
+
+  Message::Window window;
+  window.clear();
+
+  //Repeats of the newest frame are dropped
+  check(&window, 1, true);
+  check(&window, 1, false);
+
+  //Late copy of older frame through a second relay after newer one (1, 2, late 1)
+  check(&window, 2, true);
+  check(&window, 1, false);
+
+  //Copies arriving up to two frames late, interleaved from two relays
+  check(&window, 3, true);
+  check(&window, 2, false);
+  check(&window, 4, true);
+  check(&window, 2, false);
+  check(&window, 3, false);
+
+  //Numbers wrap from 7 back to 1 and are new again
+  check(&window, 5, true);
+  check(&window, 6, true);
+  check(&window, 7, true);
+  check(&window, 1, true);
+  check(&window, 7, false);
+  check(&window, 2, true);
+
+  //Up to three missed frames are still new, and a missed frame arriving late was never seen
+  check(&window, 6, true);
+  check(&window, 6, false);
+  check(&window, 5, true);
+
+  //Unnumbered frames are always kept
+  check(&window, 0, true);
+  check(&window, 0, true);
+
+  //Forgotten source (restarted) numbers from 1 again
+  window.clear();
+  check(&window, 1, true);
+
+  Serial.println(failures == 0 ? "PASS" : "FAIL");
+}
+
+void loop() {
+}
@@ -0,0 +1,94 @@
+// Include the TowerRobot Library
+#include <TowerRobot.h>
+#include <ScaledStepper.h>
+#include <Button.h>
+
+// Slide parameters
+const double stepsPerBlock = -200.0/90*27;
+const double upperLimit = 10;
+
+#define slideStep 12
+#define slideDir 13
+const int slideMode[3] = {9, 10, 11};
+
+#define limitPin 8
+
+// Creates scaled stepper
+ScaledStepper slideStepper = ScaledStepper(slideStep, slideDir, slideMode[0], slideMode[1], slideMode[2]);
+
+// Creates a limit switch
+Button limit = Button(limitPin);
+
+// Creates a slide instance
+TowerRobot::Slide slide = TowerRobot::Slide(stepsPerBlock, upperLimit, &slideStepper, &limit);
+
+// Turret parameters
+const double stepsPerDegree = -200.0*142/32/360;
+
+const int turretStep = 6;
+const int turretDir = 7;
+const int turretMode[3] = {1, 2, 4};
+
+// Creates scaled stepper
+ScaledStepper turretStepper = ScaledStepper(turretStep, turretDir, turretMode[0], turretMode[1], turretMode[2]);
+
+// Creates a turret instance
+TowerRobot::Turret turret = TowerRobot::Turret(stepsPerDegree, &turretStepper);
+
+//Gripper parameters
+#define gripPin 0
+
+//Creates gripper instance
+TowerRobot::Gripper gripper = TowerRobot::Gripper(gripPin);
+
+//Creates color sensor instance
+TowerRobot::ColorSensor colorSensor = TowerRobot::ColorSensor();
+
+//Creates IRT instance
+TowerRobot::IRT irt = TowerRobot::IRT(CONTROL_ADDRESS+1, 3, 5);
+
+//Creates towerrobot instance
+TowerRobot robot = TowerRobot(&slide, &turret, &gripper, &colorSensor, &irt);
+
+//Tuned values for this robot (upload once per robot, then flash the fleet sketch)
+const int robotAddress = CONTROL_ADDRESS+1;
+const double towerPos[4] = {0, 90, 180, 270};
+const double carryOffset = 45;
+const int gripPos[2] = {40, 185};
+const int emptyThres = 120;
+const int blockColors[4][3] = {
+  {46, 75, 63},
+  {1127, 2075, 1754},
+  {176, 79, 66},
+  {54, 184, 390}
+};
+const double sendAngle = 35;
+
+void setup() {
+  Serial.begin(9600);
+  robot.begin();
+
+  //Applies tuned values
+  irt.setAddress(robotAddress);
+  for (int i = 0; i < 4; i++) {
+    turret.setTowerPos(i, towerPos[i]);
+    colorSensor.setColorValues(i, blockColors[i][0], blockColors[i][1], blockColors[i][2]);
+  }
+  turret.setCarryOffset(carryOffset);
+  gripper.setGripPos(true, gripPos[0]);
+  gripper.setGripPos(false, gripPos[1]);
+  colorSensor.setEmptyThres(emptyThres);
+  robot.setSendAngle(sendAngle);
+
+  //Stores and reads back calibration
+  robot.saveCalibration();
+  if (robot.loadCalibration()) {
+    Serial.println("Calibration stored");
+  } else {
+    Serial.println("Calibration failed to verify");
+  }
+}
+
+void loop() {
+  
+}
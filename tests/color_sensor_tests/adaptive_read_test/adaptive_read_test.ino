@@ -0,0 +1,45 @@
+// Include the TowerRobot Library
+#include <TowerRobot.h>
+
+// Creates a color sensor instance
+TowerRobot::ColorSensor sensor = TowerRobot::ColorSensor();
+
+//Reads per trial
+int trialReads = 20;
+
+//Runs reads of a known block and prints read time, accuracy and confidence
+void trial(bool adaptive, int trueColor) {
+  sensor.setAdaptive(adaptive);
+
+  int correct = 0;
+  long confidence = 0;
+  unsigned long start = millis();
+  for (int i = 0; i < trialReads; i++) {
+    if (sensor.getBlockColor() == trueColor) {
+      correct++;
+    }
+    confidence += sensor.getConfidence();
+  }
+  unsigned long elapsed = millis() - start;
+
+  Serial.print(adaptive ? "Adaptive: " : "Fixed: ");
+  Serial.print(elapsed/trialReads); Serial.print(" ms/scan, ");
+  Serial.print(correct*100/trialReads); Serial.print("% correct, ");
+  Serial.print(confidence/trialReads); Serial.println("% confidence");
+}
+
+void setup() {
+  Serial.begin(9600);
+  sensor.begin();
+  Serial.println("Place a block and send its color (-1 empty, 0 black, 1 white, 2 red, 3 blue)");
+}
+
+void loop() {
+  if (Serial.available() > 0) {
+    int trueColor = Serial.parseInt();
+
+    //Compares fixed 50 ms reads with adaptive reads
+    trial(false, trueColor);
+    trial(true, trueColor);
+  }
+}
@@ -0,0 +1,55 @@
+// Include the TowerRobot Library
+#include <TowerRobot.h>
+
+// Creates a color sensor instance
+TowerRobot::ColorSensor sensor = TowerRobot::ColorSensor();
+
+//Reads per trial
+int trialReads = 20;
+
+//Runs reads of a known block and prints throughput and accuracy
+void trial(bool ambientModel, int trueColor) {
+  sensor.setAmbientModel(ambientModel);
+  sensor.refreshAmbient();
+
+  int correct = 0;
+  unsigned long start = millis();
+  for (int i = 0; i < trialReads; i++) {
+    int color = sensor.getBlockColor();
+    if (color == trueColor) {
+      correct++;
+    }
+
+    //Logs reading for offline classification
+    int r, g, b, c;
+    sensor.result(&r, &g, &b, &c);
+    Serial.print(ambientModel ? "model," : "full,");
+    Serial.print(trueColor); Serial.print(",");
+    Serial.print(r); Serial.print(",");
+    Serial.print(g); Serial.print(",");
+    Serial.print(b); Serial.print(",");
+    Serial.print(c); Serial.print(",");
+    Serial.println(color);
+  }
+  unsigned long elapsed = millis() - start;
+
+  Serial.print(ambientModel ? "Ambient model: " : "Full measurement: ");
+  Serial.print(elapsed/trialReads); Serial.print(" ms/scan, ");
+  Serial.print(correct*100/trialReads); Serial.println("% correct");
+}
+
+void setup() {
+  Serial.begin(9600);
+  sensor.begin();
+  Serial.println("Place a block and send its color (-1 empty, 0 black, 1 white, 2 red, 3 blue)");
+}
+
+void loop() {
+  if (Serial.available() > 0) {
+    int trueColor = Serial.parseInt();
+
+    //Compares scans with and without ambient model
+    trial(false, trueColor);
+    trial(true, trueColor);
+  }
+}
@@ -0,0 +1,32 @@
+// Include the TowerRobot Library
+#include <TowerRobot.h>
+
+// Creates a color sensor instance
+TowerRobot::ColorSensor sensor = TowerRobot::ColorSensor();
+
+//Samples averaged per learned color
+int samples = 10;
+
+void setup() {
+  Serial.begin(9600);
+  sensor.begin();
+  Serial.println("Hold a block at the sensor and send its color to learn it (-1 empty, 0 black, 1 white, 2 red, 3 blue)");
+}
+
+void loop() {
+  if (Serial.available() > 0) {
+    int color = Serial.parseInt();
+
+    if (sensor.calibrate(color, samples)) {
+      Serial.print("Learned color "); Serial.println(color);
+    } else {
+      Serial.println("Calibration failed");
+    }
+  }
+
+  //Prints classified color with confidence
+  int color = sensor.getBlockColor();
+  Serial.print("Color: "); Serial.print(color);
+  Serial.print(" Confidence: "); Serial.print(sensor.getConfidence()); Serial.println("%");
+  delay(500);
+}
@@ -70,20 +70,21 @@ int unloadTower = -1;
 //Current height of tower
 int currHeight;
 
-//Buffer array to fill with colors
-int bufferColors[10];
-
 //Array to show which towers are availiable
 bool openTowers[4] = {true, true, true, true};
 
 void setup() {
   randomSeed(analogRead(A0));
   robot.begin();
-  robot.setTowerHeights(2, 2, 2, 2);
   irt.setChannels(2);
   robot.beginYield();
-  robot.home();
-  robot.synchronize();
+
+  //Continues from saved state after a reset without resynchronizing
+  if (!robot.resume()) {
+    robot.setTowerHeights(2, 2, 2, 2);
+    robot.home();
+    robot.synchronize();
+  }
 }
 
 void loop() {
@@ -102,6 +103,9 @@ void loop() {
     slide.moveToBlock(0);
     turret.moveToCarry(turret.closestTower());
     robot.waitSlideTurret();
+
+    //Starts fresh next time
+    robot.clearState();
     while (true) {
 
     }
@@ -123,7 +127,7 @@ void loop() {
   }
   
   //Updates tower height
-  currHeight = robot.findHeight(loadTower, bufferColors);
+  currHeight = robot.findHeight(loadTower);
 
   //Ends if height is zero
   if (currHeight == 0) {
@@ -131,7 +135,7 @@ void loop() {
   }
  
   bool startedTarget;
-  int loadBlock = robot.scanTower(loadTower, targetColor, &startedTarget, bufferColors);
+  int loadBlock = robot.scanTower(loadTower, targetColor, &startedTarget);
 
   //Ensures full towers are not moved unless it is non-target blocks off of the target tower or all target blocks on non-target tower
   if ((loadBlock != 0) || (startedTarget != (loadTower == targetTower))) {
@@ -61,6 +61,6 @@ void loop() {
     irt.send(CONTROL_ADDRESS+1+i, GRIPPER, (int) gripState[i]);
     irt.waitSend();
 
-    delay(IR_CYCLE);
+    delay(irt.getCycle());
   }
 }
\ No newline at end of file
@@ -67,16 +67,17 @@ int unloadTower = -1;
 //Current height of tower
 int currHeight;
 
-//Buffer array to fill with colors
-int bufferColors[10];
-
 //Array to show which towers are availiable
 bool openTowers[4] = {true, true, true, true};
 
 void setup() {
   robot.begin();
-  robot.setTowerHeights(1, 1, 1, 1);
-  robot.home();
+
+  //Continues from saved state after a reset
+  if (!robot.resume()) {
+    robot.setTowerHeights(1, 1, 1, 1);
+    robot.home();
+  }
 }
 
 void loop() {
@@ -104,7 +105,7 @@ void loop() {
   }
 
   //Updates tower height
-  currHeight = robot.findHeight(loadTower, bufferColors);
+  currHeight = robot.findHeight(loadTower);
 
   //Ends if height is zero
   if (currHeight == 0) {
@@ -112,7 +113,7 @@ void loop() {
   }
  
   bool startedTarget;
-  int loadBlock = robot.scanTower(loadTower, targetColor, &startedTarget, bufferColors);
+  int loadBlock = robot.scanTower(loadTower, targetColor, &startedTarget);
   
   //Ensures full towers are not moved unless it is non-target blocks off of the target tower or all target blocks on non-target tower
   if ((loadBlock != 0) || (startedTarget != (loadTower == targetTower))) {
@@ -3,13 +3,63 @@
 /* Initialize IRT object */
 TowerRobot::IRT irt = TowerRobot::IRT(CONTROL_ADDRESS, 13, 5);
 
+//Whether serial parameter broadcasting is active after synchronizing
+bool paramMode = true;
+
+//Repeats of each parameter message sent to all robots
+int paramRepeats = 3;
+
 using namespace IRcommands;
 
 void setup() {
+  Serial.begin(9600);
   irt.begin();
+
+  //Relaying robots pass commands on to robots out of sight
+  irt.setSendHops(2);
+
   irt.synchronize();
 }
 
 void loop() {
-  
-}
\ No newline at end of file
+  /*
+  Parameter mode over serial:
+    "address param value" sets a parameter (address 0 reaches all robots)
+    "address -1" stores current parameters on the robot
+  */
+  if (paramMode && (Serial.available() > 0)) {
+    int address = Serial.parseInt();
+    int param = Serial.parseInt();
+
+    //Single robots acknowledge, so only master address sends are repeated
+    int repeats = (address == MASTER_ADDRESS) ? paramRepeats : 1;
+    bool delivered = true;
+
+    if (param < 0) {
+      for (int i = 0; i < repeats; i++) {
+        delivered = irt.sendSave(address);
+      }
+      Serial.println(delivered ? "Saved" : "Save not acknowledged");
+    } else {
+      double value = Serial.parseFloat();
+
+      //Repeats whole parameter frame so lost frames are covered
+      for (int i = 0; i < repeats; i++) {
+        delivered = irt.sendParam(address, param, value);
+      }
+
+      //Matches channel timing to new cycle
+      if (param == PARAM_IR_CYCLE) {
+        irt.setCycle(value);
+      }
+
+      Serial.print("Sent parameter ");
+      Serial.print(param);
+      Serial.print(" = ");
+      Serial.println(value);
+      if (!delivered) {
+        Serial.println("Not acknowledged");
+      }
+    }
+  }
+}
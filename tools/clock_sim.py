@@ -0,0 +1,102 @@
+#!/usr/bin/env python3
+"""
+clock_sim.py - Simulates how well IRT's beacon clock loop tracks a reference robot
+
+Follows IRT::readBeacon: the reference stamps each beacon with the low 14 bits
+of its network time as the frame starts. The follower adds the frame's airtime,
+unwraps the stamp around its own estimate, corrects IR_CLOCK_PHASE_GAIN of the
+error right away and adds IR_CLOCK_DRIFT_GAIN of it (per ms elapsed) to its
+drift estimate. Fractions of a ms are carried between beacons.
+
+The follower's crystal runs off by the given parts per million, and every
+beacon is decoded a random 0 to --jitter ms late. After the last beacon the
+follower runs free, showing how far slot boundaries would drift apart.
+
+    python3 clock_sim.py
+    python3 clock_sim.py --ppm 300 --jitter 5
+"""
+
+import argparse
+import math
+import random
+
+#Width of beacon stamps (Beacon::Time)
+STAMP_BITS = 14
+
+
+#Local clock of follower and its estimate of network time
+class Follower:
+    def __init__(self, phaseGain, driftGain):
+        self.phaseGain = phaseGain
+        self.driftGain = driftGain
+        self.network = 0
+        self.phase = 0.0
+        self.local = 0
+        self.drift = 0.0
+        self.locked = False
+
+    #Gets network time in whole ms and fraction of a ms (IRT::networkTime)
+    def estimate(self, local):
+        elapsed = local - self.local
+        extra = elapsed * self.drift + self.phase
+        return self.network + elapsed + math.floor(extra), extra - math.floor(extra)
+
+    #Takes in a beacon stamp decoded at local time (IRT::readBeacon)
+    def beacon(self, stamp, local):
+        estimate, fraction = self.estimate(local)
+        limit = (1 << STAMP_BITS) - 1
+        wrapped = (stamp - estimate) & limit
+        if wrapped > limit // 2:
+            wrapped -= limit + 1
+        error = wrapped - fraction
+
+        if self.locked:
+            elapsed = local - self.local
+            if elapsed > 0:
+                self.drift += self.driftGain * error / elapsed
+            phase = fraction + self.phaseGain * error
+        else:
+            phase = fraction + error
+            self.locked = True
+
+        self.network = estimate + math.floor(phase)
+        self.phase = phase - math.floor(phase)
+        self.local = local
+        return error
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Tracking error of IRT's beacon clock loop")
+    parser.add_argument("--ppm", type=float, nargs="+", default=[100, -80, 300], help="follower crystal error")
+    parser.add_argument("--interval", type=int, default=1000, help="IR_BEACON_INTERVAL (ms)")
+    parser.add_argument("--beacons", type=int, default=900)
+    parser.add_argument("--jitter", type=float, default=3, help="most decode delay (ms)")
+    parser.add_argument("--phase-gain", type=float, default=0.25, help="IR_CLOCK_PHASE_GAIN")
+    parser.add_argument("--drift-gain", type=float, default=0.01, help="IR_CLOCK_DRIFT_GAIN")
+    parser.add_argument("--free-run", type=int, default=30000, help="time without beacons after last one (ms)")
+    parser.add_argument("--seed", type=int, default=1)
+    args = parser.parse_args()
+
+    print(f"{'ppm':>6}  {'learned ppm':>11}  {'max error':>9}  {'free run error':>14}")
+    for ppm in args.ppm:
+        rng = random.Random(args.seed)
+        follower = Follower(args.phase_gain, args.drift_gain)
+        rate = 1 - ppm * 1e-6
+
+        #Network time of each beacon, with airtime already added by receiver
+        t = 5000.0
+        errors = []
+        for _ in range(args.beacons):
+            t += args.interval
+            local = int((t + rng.uniform(0, args.jitter)) * rate)
+            errors.append(follower.beacon(int(t) & ((1 << STAMP_BITS) - 1), local))
+
+        #Error once settled, then after running without beacons
+        settled = max(abs(error) for error in errors[len(errors) // 2:])
+        end = t + args.free_run
+        estimate, fraction = follower.estimate(int(end * rate))
+        print(f"{ppm:6.0f}  {follower.drift * 1e6:11.1f}  {settled:9.1f}  {estimate + fraction - end:14.1f}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,140 @@
+#!/usr/bin/env python3
+"""
+height_search_sim.py - Checks TowerRobot::findHeight's search against every case
+
+Follows findHeight: the height is at least one above the highest block the
+model already knows and at most one above the highest level the sensor can
+reach. The search gallops up or down from the predicted height in doubling
+steps, then bisects what is left. Probes of known levels are answered without
+scanning, as readColor does.
+
+Every true height, prediction and number of known blocks up to --levels is
+tried. The script fails if any search returns the wrong height, and prints the
+most scans any search needed next to stepping one level at a time from the
+prediction.
+
+    python3 height_search_sim.py
+    python3 height_search_sim.py --levels 16 --reach 12
+"""
+
+import argparse
+import sys
+
+
+#Tower with true height whose lowest levels are already known
+class Tower:
+    def __init__(self, height, known):
+        self.height = height
+        self.known = set(range(known))
+        self.scans = 0
+
+    #Whether a block is at level (TowerRobot::occupied)
+    def occupied(self, level):
+        if level not in self.known:
+            self.scans += 1
+            self.known.add(level)
+        return level < self.height
+
+
+#Finds height of tower by galloping from predicted height then bisecting (TowerRobot::findHeight)
+def findHeight(tower, pred, reach, levels):
+    #Height is at least one above highest known block
+    low = max(tower.known) + 1 if tower.known else 0
+
+    #Height is at most one above highest level the sensor can reach
+    high = min(reach + 1, levels)
+    low = min(low, high)
+
+    #Starts from predicted tower height
+    pred = max(low, min(pred, high))
+
+    if pred < high and tower.occupied(pred):
+        #Gallops up with doubling steps until a level is empty
+        low = pred + 1
+        step = 1
+        while low < high:
+            probe = min(pred + step, high - 1)
+            if tower.occupied(probe):
+                low = probe + 1
+            else:
+                high = probe
+                break
+            step *= 2
+    else:
+        #Gallops down with doubling steps until a level has a block
+        high = pred
+        step = 1
+        while low < high:
+            probe = max(pred - step, low)
+            if tower.occupied(probe):
+                low = probe + 1
+                break
+            else:
+                high = probe
+            step *= 2
+
+    #Bisects remaining range
+    while low < high:
+        mid = (low + high) // 2
+        if tower.occupied(mid):
+            low = mid + 1
+        else:
+            high = mid
+
+    return low
+
+
+#Finds height by stepping one level at a time from predicted height, for comparison
+def linearHeight(tower, pred, reach, levels):
+    low = max(tower.known) + 1 if tower.known else 0
+    high = min(reach + 1, levels)
+    level = max(min(low, high), min(pred, high))
+
+    #Steps up past blocks, or down past empty levels
+    while level < high and tower.occupied(level):
+        level += 1
+    while level > low and not tower.occupied(level - 1):
+        level -= 1
+    return level
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Exhaustive check of findHeight's galloping search")
+    parser.add_argument("--levels", type=int, default=10, help="MAX_LEVELS")
+    parser.add_argument("--reach", type=int, default=9, help="highest level sensor can reach (upperLimit - sensorMargin)")
+    args = parser.parse_args()
+
+    print(f"{'error':>5}  {'cases':>5}  {'most scans':>10}  {'linear':>6}")
+    worst = {}
+    failures = 0
+    for height in range(args.levels + 1):
+        for pred in range(args.levels + 1):
+            for known in range(height + 1):
+                tower = Tower(height, known)
+                found = findHeight(tower, pred, args.reach, args.levels)
+
+                #Towers above the sensor's reach read as one above it
+                expected = min(height, args.reach + 1, args.levels)
+                if found != expected:
+                    failures += 1
+                    print(f"height {height}, prediction {pred}, {known} known: found {found}", file=sys.stderr)
+
+                linear = Tower(height, known)
+                linearHeight(linear, pred, args.reach, args.levels)
+
+                error = abs(expected - pred)
+                cases, scans, linearScans = worst.get(error, (0, 0, 0))
+                worst[error] = (cases + 1, max(scans, tower.scans), max(linearScans, linear.scans))
+
+    for error in sorted(worst):
+        cases, scans, linearScans = worst[error]
+        print(f"{error:5}  {cases:5}  {scans:10}  {linearScans:6}")
+
+    if failures:
+        print(f"{failures} searches returned the wrong height", file=sys.stderr)
+        sys.exit(1)
+    print("All searches found the true height")
+
+
+if __name__ == "__main__":
+    main()
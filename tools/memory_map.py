@@ -0,0 +1,109 @@
+#!/usr/bin/env python3
+"""
+memory_map.py - Breaks down static RAM use from a linker map file
+
+Build with a map file, for example:
+    arduino-cli compile --build-property "compiler.c.elf.extra_flags=-Wl,-Map,build.map" ...
+
+Then run:
+    python3 memory_map.py build.map
+
+RAM sections (.data and .bss) are grouped by the class that owns them. Library
+objects are named after their source file (IRT.cpp -> TowerRobot::IRT), sketch
+globals are listed individually and everything else is grouped by library.
+"""
+
+import argparse
+import os
+import re
+import shutil
+import subprocess
+import sys
+from collections import defaultdict
+
+#Source files whose objects belong to a nested TowerRobot class
+NESTED_CLASSES = {"Slide", "Turret", "Gripper", "ColorSensor", "IRT"}
+
+#Input section line, optionally wrapped onto the next line by the linker
+SECTION = re.compile(r"^ (\.(?:data|bss)(?:\.\S+)?)\s*(?:\n\s+)?\s(0x[0-9a-f]+)\s+(0x[0-9a-f]+)\s+(\S+)", re.M)
+
+
+#Demangles symbol names if c++filt is availiable
+def demangle(names):
+    tool = shutil.which("avr-c++filt") or shutil.which("c++filt")
+    if not tool or not names:
+        return {name: name for name in names}
+
+    out = subprocess.run([tool], input="\n".join(names), capture_output=True, text=True).stdout
+    return dict(zip(names, out.splitlines()))
+
+
+#Gets owning class of a section from its object file and symbol
+def owner(obj, symbol, sketch):
+    #Archive members look like path/core.a(file.o)
+    member = re.search(r"\(([^)]+)\)$", obj)
+    base = os.path.basename(member.group(1) if member else obj)
+    stem = base.split(".")[0]
+
+    if sketch and (sketch in obj) and (".ino" in base):
+        #Sketch globals are listed one by one
+        return "sketch: " + (symbol or "(unnamed)")
+    elif stem in NESTED_CLASSES:
+        return "TowerRobot::" + stem
+    elif member:
+        return os.path.basename(obj.split("(")[0]) + ": " + stem
+    else:
+        return stem
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Per-class static RAM breakdown from a linker map file")
+    parser.add_argument("mapfile")
+    parser.add_argument("--sketch", default="sketch", help="path fragment identifying sketch objects")
+    parser.add_argument("--symbols", action="store_true", help="list symbols under each class")
+    args = parser.parse_args()
+
+    with open(args.mapfile) as f:
+        text = f.read()
+
+    #Only input sections after the memory map header are placed
+    start = text.find("Linker script and memory map")
+    if start >= 0:
+        text = text[start:]
+
+    entries = []
+    for section, addr, size, obj in SECTION.findall(text):
+        size = int(size, 16)
+        if size == 0:
+            continue
+
+        #Sections named .bss.<symbol> come from -fdata-sections
+        parts = section.split(".", 2)
+        symbol = parts[2] if len(parts) > 2 else ""
+        entries.append((section, symbol, size, obj))
+
+    names = demangle(sorted({symbol for _, symbol, _, _ in entries if symbol}))
+
+    totals = defaultdict(int)
+    symbols = defaultdict(list)
+    for section, symbol, size, obj in entries:
+        name = names.get(symbol, symbol)
+        key = owner(obj, name, args.sketch)
+        totals[key] += size
+        symbols[key].append((size, section.split(".")[1], name))
+
+    if not totals:
+        sys.exit("No .data or .bss sections found in " + args.mapfile)
+
+    width = max(len(key) for key in totals)
+    for key, size in sorted(totals.items(), key=lambda item: -item[1]):
+        print(f"{key:<{width}}  {size:6d}")
+        if args.symbols:
+            for symSize, kind, name in sorted(symbols[key], reverse=True):
+                print(f"    {kind:<4} {symSize:6d}  {name or '(unnamed)'}")
+
+    print(f"{'Total':<{width}}  {sum(totals.values()):6d}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,142 @@
+#!/usr/bin/env python3
+"""
+slot_sim.py - Simulates yield frame latency under fixed and dynamic IR time slots
+
+Fixed slots follow IRT with setChannels(robots): every robot owns a channel of
+IR_CYCLE ms by address, whether or not it has anything to send.
+
+Dynamic slots follow IRT with setDynamicSlots(true): each round is a join slot
+followed by one slot per robot heard within IR_SLOT_IDLE ms, in address order.
+Slots are one frame plus IR_SLOT_GUARD ms long. Robots without a slot try the
+join slot with a chance of one in the number of robots without a slot (at least
+IR_JOIN_BACKOFF), and joins sent together collide.
+
+Every robot yields at random (a yield frame, then DONE once it leaves the
+tower). Latency is the time from queuing a frame until it has been sent. All
+robots are assumed to hear each other.
+
+    python3 slot_sim.py
+    python3 slot_sim.py --protocol line --rate 20
+"""
+
+import argparse
+import random
+
+#Airtime of a frame in each protocol (IR_FRAME_TIME, IR_LINE_FRAME_TIME)
+FRAME_TIME = {"nec": 68, "line": 31}
+
+
+#Builds frames each robot queues as (time queued, whether it is a yield frame)
+def traffic(robots, duration, rate, hold, rng):
+    queues = []
+    for _ in range(robots):
+        frames = []
+        t = rng.expovariate(rate / 60000)
+        while t < duration:
+            frames.append((t, True))
+            frames.append((t + rng.uniform(*hold), False))
+            t += rng.expovariate(rate / 60000)
+        queues.append(sorted(frames))
+    return queues
+
+
+#Sends queued frame if it can start early enough in slot (returns send time or None)
+def ready(queue, start, latest):
+    if queue and queue[0][0] <= latest:
+        return max(start, queue[0][0])
+    return None
+
+
+#Robot owns every robots-th channel of cycle ms, sending frames back to back while they fit
+def fixed(queues, duration, frame, cycle):
+    latencies = []
+    robots = len(queues)
+    channel = 0
+    while channel * cycle < duration:
+        owner = queues[channel % robots]
+        t = channel * cycle
+        end = t + cycle
+        while (start := ready(owner, t, end - frame)) is not None:
+            queued, isYield = owner.pop(0)
+            if isYield:
+                latencies.append(start + frame - queued)
+            t = start + frame
+        channel += 1
+    return latencies, 0
+
+
+#Rounds of a join slot and a slot per recently heard robot
+def dynamic(queues, duration, frame, guard, idle, backoff, rng):
+    latencies = []
+    collisions = 0
+    slot = frame + guard
+    heard = [None] * len(queues)
+
+    def sent(robot, start):
+        queued, isYield = queues[robot].pop(0)
+        if isYield:
+            latencies.append(start + frame - queued)
+        heard[robot] = start
+
+    t = 0
+    while t < duration:
+        active = [r for r in range(len(queues)) if heard[r] is not None and t - heard[r] <= idle]
+
+        #Robots with traffic and no slot try to join, backing off by number of robots that could
+        waiting = max(backoff, len(queues) - len(active))
+        joins = []
+        for r in range(len(queues)):
+            if r not in active and ready(queues[r], t, t + guard) is not None and rng.randrange(waiting) == 0:
+                joins.append(r)
+        if len(joins) == 1:
+            sent(joins[0], ready(queues[joins[0]], t, t + guard))
+        elif joins:
+            collisions += 1
+
+        #Each active robot sends at most one frame in its own slot
+        for index, r in enumerate(active):
+            start = t + (index + 1) * slot
+            send = ready(queues[r], start, start + guard)
+            if send is not None:
+                sent(r, send)
+
+        t += slot * (len(active) + 1)
+    return latencies, collisions
+
+
+#Gets value at fraction of sorted values
+def percentile(values, fraction):
+    values = sorted(values)
+    return values[min(len(values) - 1, int(fraction * len(values)))]
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Yield latency of fixed and dynamic IR time slots")
+    parser.add_argument("--robots", type=int, nargs=2, default=[2, 12], metavar=("MIN", "MAX"))
+    parser.add_argument("--protocol", choices=FRAME_TIME, default="nec")
+    parser.add_argument("--rate", type=float, default=6, help="yields per robot per minute")
+    parser.add_argument("--duration", type=float, default=600, help="simulated seconds")
+    parser.add_argument("--cycle", type=int, default=200, help="IR_CYCLE (ms)")
+    parser.add_argument("--guard", type=int, default=12, help="IR_SLOT_GUARD (ms)")
+    parser.add_argument("--idle", type=int, default=20000, help="IR_SLOT_IDLE (ms)")
+    parser.add_argument("--backoff", type=int, default=2, help="IR_JOIN_BACKOFF")
+    parser.add_argument("--seed", type=int, default=1)
+    args = parser.parse_args()
+
+    frame = FRAME_TIME[args.protocol]
+    duration = args.duration * 1000
+
+    print(f"{'robots':>6}  {'fixed mean':>10} {'p95':>6}  {'dynamic mean':>12} {'p95':>6} {'joins lost':>10}")
+    for robots in range(args.robots[0], args.robots[1] + 1):
+        rng = random.Random(args.seed + robots)
+        queues = traffic(robots, duration, args.rate, (2000, 6000), rng)
+
+        fixedLat, _ = fixed([list(q) for q in queues], duration, frame, args.cycle)
+        dynamicLat, collisions = dynamic([list(q) for q in queues], duration, frame, args.guard, args.idle, args.backoff, rng)
+
+        print(f"{robots:>6}  {sum(fixedLat) / len(fixedLat):10.0f} {percentile(fixedLat, 0.95):6.0f}  "
+              f"{sum(dynamicLat) / len(dynamicLat):12.0f} {percentile(dynamicLat, 0.95):6.0f} {collisions:>10}")
+
+
+if __name__ == "__main__":
+    main()